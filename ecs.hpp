@@ -24,32 +24,104 @@
 #ifndef __ECS_HPP__
 #define __ECS_HPP__
 
+#include <algorithm>
 #include <array>
+#include <atomic>
 #include <cassert>
+#include <chrono>
 #include <cinttypes>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
 #include <ctime>
+#include <deque>
+#include <functional>
 #include <initializer_list>
 #include <iostream>
-#include <list>
+#include <limits>
+#include <memory_resource>
+#include <mutex>
+#include <numeric>
+#include <shared_mutex>
+#include <span>
 #include <string>
+#include <thread>
 #include <tuple>
+#include <type_traits>
+#include <utility>
 #include <vector>
 
-#define ECS_TYPE_CONTRADICTION_ASSERT(CONDITION, TYPE_NAME, OTHER_TYPE_NAME, FUNCTION_NAME)       \
-    if (!(CONDITION))                                                                             \
-    {                                                                                             \
-        std::cout << std::string("ECS ASSERT: cannot ") + FUNCTION_NAME + " " + OTHER_TYPE_NAME + \
-                         " in object pool for " + TYPE_NAME;                                      \
-        std::exit(-1);                                                                            \
-    }
+#if defined(__linux__)
+#    include <fcntl.h>
+#    include <sys/mman.h>
+#    include <sys/stat.h>
+#    include <sys/syscall.h>
+#    include <unistd.h>
+#endif
+
+#ifndef NDEBUG
+#    define ECS_TYPE_CONTRADICTION_ASSERT(CONDITION, TYPE_NAME, OTHER_TYPE_NAME, FUNCTION_NAME)   \
+        if (!(CONDITION))                                                                         \
+        {                                                                                         \
+            std::cout << std::string("ECS ASSERT: cannot ") + FUNCTION_NAME + " " +               \
+                             OTHER_TYPE_NAME + " in object pool for " + TYPE_NAME;                \
+            std::exit(-1);                                                                        \
+        }
+#else
+#    define ECS_TYPE_CONTRADICTION_ASSERT(CONDITION, TYPE_NAME, OTHER_TYPE_NAME, FUNCTION_NAME)
+#endif
+
+/**
+ * Define ECS_ENABLE_STATS before including to count pool lookups and view iterations, see
+ * ObjectPoolStats. The counters don't exist when it isn't defined
+ */
+#ifdef ECS_ENABLE_STATS
+#    define ECS_STATS_INCREMENT(COUNTER, AMOUNT) \
+        (COUNTER).fetch_add(AMOUNT, std::memory_order_relaxed)
+#else
+#    define ECS_STATS_INCREMENT(COUNTER, AMOUNT)
+#endif
+
+/**
+ * Opens a profiler zone that lasts until the end of the enclosing scope around view iteration
+ * and system execution. Define it before including to forward to a profiler, for example
+ * ZoneScopedN(NAME) for Tracy or TRACE_EVENT("ecs", NAME) for Perfetto. NAME is always a string
+ * literal
+ */
+#ifndef ECS_PROFILE_SCOPE
+#    define ECS_PROFILE_SCOPE(NAME)
+#endif
 
 #define ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE 30
 
+#define ECS_VIEW_DEFAULT_GRAIN_SIZE 1024
+
+#define ECS_COMMAND_BUFFER_ARENA_BLOCK_SIZE 16384
+
+#define ECS_HUGE_PAGE_SIZE 2097152
+
+#define ECS_SIMD_ALIGNMENT 64
+
+#define ECS_SNAPSHOT_MAGIC 0x00534345
+
+#define ECS_SNAPSHOT_VERSION 1
+
+#define ECS_DELTA_MAGIC 0x00444345
+
+#define ECS_DELTA_VERSION 1
+
 #define ECS_ENTITY_DESTROYED \
     ecs::Entity { std::string::npos }
 
+#define ECS_ENTITY_MAX_GENERATION 0xfffffffd
+
+#define ECS_REGISTRY_FREE_LIST_END 0xffffffff
+
 namespace ecs {
 
+typedef std::byte byte;
+
 namespace type_descriptor {
 
     /**
@@ -169,7 +241,6 @@ namespace type_descriptor {
         for (std::size_t i = 0; i < substr.size(); i++)
             substr[i] = offset_wrapped_type_name[i];
 
-        substr[substr.size()] = '\0';
         return substr;
     }
 
@@ -195,17 +266,60 @@ namespace type_descriptor {
         return hash;
     }
 
+    /**
+     * @brief Hash of the type name, the same value ObjectPool::get_type_hash() uses for _T
+     */
+    template<typename _T>
+    constexpr std::uint64_t get_hash()
+    {
+        return get_hash(get_name<_T>());
+    }
+
+    /**
+     * @brief Hands out the next unused dense type index
+     */
+    inline std::size_t next_index()
+    {
+        static std::atomic<std::size_t> counter = 0;
+        return counter.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    /**
+     * @brief Dense index of the type that is assigned the first time it's requested. Unlike the
+     * hash it is small enough to index arrays directly, but it isn't stable between runs so it
+     * should never be serialized
+     *
+     * @tparam _T Target type
+     * @return std::size_t Index that is unique to _T for the lifetime of the program
+     */
+    template<typename _T>
+    inline std::size_t get_index()
+    {
+        static const std::size_t index = next_index();
+        return index;
+    }
+
 } // namespace type_descriptor
 
 /**
  * @class Entity
- * @brief Unique Id used to identify groups of components that belong to the same entity
+ * @brief Unique Id used to identify groups of components that belong to the same entity. The low
+ * 32 bits are the index of the entity in the registry and the high 32 bits the generation of
+ * that index, which is bumped every time the index is destroyed so old handles stop matching
  */
 struct Entity
 {
-    std::size_t id = 0;
+    std::uint64_t id = 0;
+
+    static constexpr Entity create(std::uint32_t index, std::uint32_t generation)
+    {
+        return Entity{static_cast<std::uint64_t>(generation) << 32 | index};
+    }
 
-    inline operator std::size_t() { return id; }
+    inline std::uint32_t get_index() const { return static_cast<std::uint32_t>(id); }
+    inline std::uint32_t get_generation() const { return static_cast<std::uint32_t>(id >> 32); }
+
+    inline operator std::size_t() const { return id; }
     inline bool operator==(const Entity& other) const { return id == other.id; }
     inline bool operator!=(const Entity& other) const { return id != other.id; }
 };
@@ -223,6 +337,70 @@ struct ObjectPoolChunk
 
 typedef void (*fnptr_objectpool_type_deconstructor)(std::byte* type);
 typedef void (*fnptr_objectpool_type_default_constructor)(std::byte* type);
+typedef void (*fnptr_objectpool_type_relocator)(std::byte* target, std::byte* source);
+typedef void (*fnptr_objectpool_type_copy_constructor)(std::byte* target, const std::byte* source);
+
+/**
+ * @enum ObjectPoolLayout
+ * @brief How an object pool stores its objects in memory
+ *
+ * Chunked: every object is prefixed by an ObjectPoolChunk and lives in a fixed size block, so
+ * object addresses never change while the object is alive.
+ *
+ * Packed: every object is stored in one contiguous array indexed the same way as
+ * ObjectPool::get_dense_entities(). Removal moves the last object into the freed slot, so
+ * pointers to objects are only valid until the next malloc or free on the pool.
+ */
+enum class ObjectPoolLayout
+{
+    Chunked,
+    Packed,
+};
+
+/**
+ * @enum SortAlgorithm
+ * @brief Standard uses std::sort, Insertion is cheaper when the pool is already nearly sorted,
+ * such as when it's sorted again every frame
+ */
+enum class SortAlgorithm
+{
+    Standard,
+    Insertion,
+};
+
+/**
+ * @class ObjectPoolStats
+ * @brief Snapshot of an object pool's memory use. lookups and iterations are only counted when
+ * ECS_ENABLE_STATS is defined, otherwise they're always 0
+ *
+ * fragmentation is the share of chunks below the chunk chain's next untouched chunk that are
+ * freed, packed pools never have gaps so it's always 0 for them
+ */
+struct ObjectPoolStats
+{
+    std::size_t count = 0;
+    std::size_t capacity = 0;
+    std::size_t free_count = 0;
+    std::size_t block_count = 0;
+    std::size_t reserved_bytes = 0;
+    std::size_t used_bytes = 0;
+    double fragmentation = 0.0;
+    std::uint64_t lookups = 0;
+    std::uint64_t iterations = 0;
+};
+
+class ObjectPoolGroup;
+
+/**
+ * @class ObjectPoolRemoval
+ * @brief Entity whose object was removed from a pool with change tracking and the tick it was
+ * removed at
+ */
+struct ObjectPoolRemoval
+{
+    Entity entity = {};
+    std::uint64_t tick = 0;
+};
 
 /**
  * @class ObjectPool
@@ -232,68 +410,175 @@ typedef void (*fnptr_objectpool_type_default_constructor)(std::byte* type);
 class ObjectPool
 {
   public:
+    /**
+     * @brief Creates a pool for _T, the pool itself and all of its storage is allocated from the
+     * memory resource. It has to be released with ObjectPool::destroy()
+     */
     template<typename _T>
-    static ObjectPool* create(std::size_t block_size)
+    static ObjectPool* create(
+        std::size_t block_size, ObjectPoolLayout layout = ObjectPoolLayout::Chunked,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        std::size_t alignment = alignof(_T)
+    )
     {
-        ObjectPool* pool = new ObjectPool(
+        ObjectPool* pool = std::pmr::polymorphic_allocator<ObjectPool>(resource).new_object<ObjectPool>(
             std::string(
                 type_descriptor::get_name<_T>().data(), type_descriptor::get_name<_T>().size()
             ),
-            sizeof(_T), type_descriptor::get_hash(type_descriptor::get_name<_T>()), block_size
+            sizeof(_T), type_descriptor::get_hash<_T>(), block_size, layout, resource,
+            std::max(alignment, alignof(_T))
         );
 
-        pool->m_type_default_constructor = [](std::byte* target)
+        if constexpr (std::is_default_constructible_v<_T>)
         {
-            _T* target_type = reinterpret_cast<_T*>(target);
-            new (target_type) _T();
-        };
+            pool->m_type_default_constructor = [](std::byte* target)
+            {
+                _T* target_type = reinterpret_cast<_T*>(target);
+                new (target_type) _T();
+            };
+        }
 
-        pool->m_type_deconstructor = [](std::byte* target)
+        if constexpr (!std::is_trivially_destructible_v<_T>)
         {
-            _T* target_type = reinterpret_cast<_T*>(target);
-            target_type->~_T();
-        };
+            pool->m_type_deconstructor = [](std::byte* target)
+            {
+                _T* target_type = reinterpret_cast<_T*>(target);
+                target_type->~_T();
+            };
+        }
+
+        // Trivially copyable types keep the null relocator and copy constructor so they're
+        // moved and copied with std::memcpy, packed arrays are then relocated in one call
+        if constexpr (!std::is_trivially_copyable_v<_T>)
+        {
+            pool->m_type_relocator = [](std::byte* target, std::byte* source)
+            {
+                _T* source_type = reinterpret_cast<_T*>(source);
+                new (reinterpret_cast<_T*>(target)) _T(std::move(*source_type));
+                source_type->~_T();
+            };
+        }
+
+        if constexpr (std::is_trivially_copyable_v<_T> && std::is_copy_constructible_v<_T>)
+            pool->m_type_trivially_copyable = true;
+        else if constexpr (std::is_copy_constructible_v<_T>)
+        {
+            pool->m_type_copy_constructor = [](std::byte* target, const std::byte* source)
+            { new (reinterpret_cast<_T*>(target)) _T(*reinterpret_cast<const _T*>(source)); };
+        }
+
+        return pool;
+    }
+
+    /**
+     * @brief Creates a runtime typed pool allocated from the memory resource, it has to be
+     * released with ObjectPool::destroy()
+     */
+    static ObjectPool* create(
+        const std::string& name, std::size_t size, std::uint64_t hash, std::size_t block_size,
+        ObjectPoolLayout layout = ObjectPoolLayout::Chunked,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        std::size_t alignment = alignof(std::max_align_t)
+    )
+    {
+        return std::pmr::polymorphic_allocator<ObjectPool>(resource).new_object<ObjectPool>(
+            name, size, hash, block_size, layout, resource, alignment
+        );
+    }
 
+    /**
+     * @brief Creates an empty pool for the same type as other, with the same layout and type
+     * erased operations, allocated from the memory resource
+     */
+    static ObjectPool* create_like(
+        const ObjectPool& other, std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    )
+    {
+        ObjectPool* pool = create(
+            other.m_type_name, other.m_type_size, other.m_type_hash, other.m_block_size,
+            other.m_layout, resource, other.m_type_alignment
+        );
+        pool->m_type_default_constructor = other.m_type_default_constructor;
+        pool->m_type_deconstructor = other.m_type_deconstructor;
+        pool->m_type_relocator = other.m_type_relocator;
+        pool->m_type_copy_constructor = other.m_type_copy_constructor;
+        pool->m_type_trivially_copyable = other.m_type_trivially_copyable;
         return pool;
     }
 
+    static void destroy(ObjectPool* pool)
+    {
+        std::pmr::polymorphic_allocator<ObjectPool>(pool->m_resource).delete_object(pool);
+    }
+
   public:
     ObjectPool() = default;
 
+    /**
+     * @brief alignment is what every object of the pool is aligned to, it has to be a power of 2
+     * that is at least the alignment of the type. Chunks are padded so every object and chunk
+     * header stays aligned, packed arrays start at the alignment and grow in steps that keep
+     * their size in bytes a multiple of it
+     */
     ObjectPool(
-        const std::string& name, std::size_t size, std::uint64_t hash, std::size_t block_size
+        const std::string& name, std::size_t size, std::uint64_t hash, std::size_t block_size,
+        ObjectPoolLayout layout = ObjectPoolLayout::Chunked,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        std::size_t alignment = alignof(std::max_align_t)
     )
-        : m_type_name(name), m_type_size(size), m_type_hash(hash), m_block_size(block_size)
+        : m_type_name(name), m_type_size(size), m_type_hash(hash), m_block_size(block_size),
+          m_layout(layout), m_type_alignment(alignment),
+          m_chunk_offset(_align(sizeof(ObjectPoolChunk), alignment)),
+          m_chunk_stride(_align(
+              m_chunk_offset + size, std::max(alignment, alignof(ObjectPoolChunk))
+          )),
+          m_packed_granularity(std::lcm(size, alignment) / size), m_resource(resource),
+          m_blocks(resource), m_allocations(resource), m_freed_locations(resource),
+          m_sparse(resource), m_dense_entities(resource), m_dense_chunks(resource),
+          m_added_ticks(resource), m_changed_ticks(resource), m_removed(resource)
     {
         assert(m_type_name.size() > 0 && "ECS ASSERT: m_type_name must be larget than 0");
         assert(m_type_size > 0 && "ECS ASSERT: m_type_size must be larger than 0");
         assert(m_block_size > 0 && "ECS ASSERT: m_block_size must be larger than 0");
+        assert(
+            alignment > 0 && (alignment & (alignment - 1)) == 0 &&
+            "ECS ASSERT: alignment must be a power of 2"
+        );
     }
 
     ~ObjectPool()
     {
-        for (std::list<std::byte*>::iterator it = m_blocks.begin(); it != m_blocks.end(); it++)
+        _deallocate(m_swap_slot, m_type_size);
+
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            if (m_type_deconstructor != nullptr)
+            {
+                for (std::size_t i = 0; i < m_dense_entities.size(); i++)
+                    m_type_deconstructor(m_packed + m_type_size * i);
+            }
+
+            _release_packed();
+            return;
+        }
+
+        for (auto it = m_blocks.begin(); it != m_blocks.end(); it++)
         {
             for (std::size_t i = 0; i < m_block_size; i++)
             {
-                ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(
-                    *it + (sizeof(ObjectPoolChunk) + m_type_size) * i
-                );
+                ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(*it + m_chunk_stride * i);
                 if (chunk->entity != ECS_ENTITY_DESTROYED)
                 {
                     if (m_type_deconstructor != nullptr)
                     {
-                        std::byte* target = reinterpret_cast<std::byte*>(
-                            *it +
-                            ((sizeof(ObjectPoolChunk) + m_type_size) * i + sizeof(ObjectPoolChunk))
-                        );
-                        m_type_deconstructor(target);
+                        m_type_deconstructor(*it + m_chunk_stride * i + m_chunk_offset);
                     }
                 }
             }
-
-            std::free(*it);
         }
+
+        for (const Allocation& allocation : m_allocations)
+            _deallocate(allocation.data, allocation.size);
     }
 
     inline void set_default_constructor(fnptr_objectpool_type_default_constructor constructor)
@@ -306,521 +591,5321 @@ class ObjectPool
         m_type_deconstructor = deconstructor;
     }
 
-    inline const std::string& get_name() const { return m_type_name; }
-    inline std::size_t get_type_size() const { return m_type_size; }
-    inline std::uint64_t get_type_hash() const { return m_type_hash; }
-    inline std::size_t get_block_size() const { return m_block_size; }
-
-    inline const std::vector<ObjectPoolChunk*> get_free_locations() const
+    /**
+     * @brief Sets how objects are moved between slots of a packed pool. When not set objects are
+     * relocated with std::memcpy
+     */
+    inline void set_relocator(fnptr_objectpool_type_relocator relocator)
     {
-        return m_freed_locations;
+        m_type_relocator = relocator;
     }
 
-    inline const std::list<std::byte*>& get_blocks() const { return m_blocks; }
-    inline std::list<std::byte*>& get_blocks() { return m_blocks; }
-
-    template<typename _T, typename... _Args>
-    _T* malloc(Entity entity, _Args... args)
+    inline void set_copy_constructor(fnptr_objectpool_type_copy_constructor copy_constructor)
     {
-        ECS_TYPE_CONTRADICTION_ASSERT(
-            std::string(
-                type_descriptor::get_name<_T>().data(), type_descriptor::get_name<_T>().size()
-            ) == m_type_name,
-            m_type_name, type_descriptor::get_name<_T>().data(), "malloc"
-        );
+        m_type_copy_constructor = copy_constructor;
+    }
 
-        if (m_freed_locations.size() > 0)
-        {
-            _T* object = _construct<_T>(entity, m_freed_locations.back(), args...);
-            m_freed_locations.pop_back();
+    /**
+     * @brief Marks the objects as safe to copy with std::memcpy, used by runtime typed pools that
+     * have no copy constructor. Typed pools detect this from std::is_trivially_copyable
+     */
+    inline void set_trivially_copyable(bool trivially_copyable)
+    {
+        m_type_trivially_copyable = trivially_copyable;
+    }
 
-            return object;
-        }
-        else if (m_next == nullptr)
-            _allocate_block();
+    /**
+     * @brief Objects are relocated with std::memcpy when the pool has no relocator
+     */
+    inline bool is_trivially_relocatable() const { return m_type_relocator == nullptr; }
+    inline bool is_trivially_copyable() const { return m_type_trivially_copyable; }
 
-        return _construct<_T>(entity, m_next, args...);
+    inline bool is_copyable() const
+    {
+        return m_type_trivially_copyable || m_type_copy_constructor != nullptr;
     }
 
-    std::byte* malloc(Entity entity)
-    {
-        if (m_freed_locations.size() > 0)
-        {
-            std::byte* object = _construct(entity, m_freed_locations.back());
-            m_freed_locations.pop_back();
+    inline const std::string& get_name() const { return m_type_name; }
+    inline std::size_t get_type_size() const { return m_type_size; }
+    inline std::size_t get_type_alignment() const { return m_type_alignment; }
 
-            return object;
-        }
-        else if (m_next == nullptr)
-            _allocate_block();
+    /**
+     * @brief Distance between the start of two chunks in a block and from the start of a chunk
+     * to its object
+     */
+    inline std::size_t get_chunk_stride() const { return m_chunk_stride; }
+    inline std::size_t get_chunk_offset() const { return m_chunk_offset; }
+    inline std::uint64_t get_type_hash() const { return m_type_hash; }
+    inline std::size_t get_block_size() const { return m_block_size; }
+    inline ObjectPoolLayout get_layout() const { return m_layout; }
 
-        return _construct(entity, m_next);
-    }
+    inline std::pmr::memory_resource* get_resource() const { return m_resource; }
 
-    template<typename _T>
-    void free(_T* type)
+    inline const std::pmr::vector<ObjectPoolChunk*>& get_free_locations() const
     {
-        ECS_TYPE_CONTRADICTION_ASSERT(
-            std::string(
-                type_descriptor::get_name<_T>().data(), type_descriptor::get_name<_T>().size()
-            ) == m_type_name,
-            m_type_name, type_descriptor::get_name<_T>().data(), "free"
-        );
+        return m_freed_locations;
+    }
 
-        type->~_T();
+    inline const std::pmr::vector<std::byte*>& get_blocks() const { return m_blocks; }
+    inline std::pmr::vector<std::byte*>& get_blocks() { return m_blocks; }
 
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(
-            reinterpret_cast<std::byte*>(type) - sizeof(ObjectPoolChunk)
-        );
-        chunk->entity = ECS_ENTITY_DESTROYED;
-        m_freed_locations.push_back(chunk);
-    }
+    /**
+     * @brief Entities that currently own an object in this pool, packed without gaps. The order
+     * matches get_object(index) and, for chunked pools, get_dense_chunks()
+     */
+    inline const std::pmr::vector<Entity>& get_dense_entities() const { return m_dense_entities; }
 
-    void free(std::byte* ptr)
+    inline const std::pmr::vector<ObjectPoolChunk*>& get_dense_chunks() const
     {
-        m_type_deconstructor(ptr);
-
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(
-            reinterpret_cast<std::byte*>(ptr) - sizeof(ObjectPoolChunk)
-        );
-        chunk->entity = ECS_ENTITY_DESTROYED;
-        m_freed_locations.push_back(chunk);
+        return m_dense_chunks;
     }
+    inline std::size_t get_count() const { return m_dense_entities.size(); }
 
-    void free(ObjectPoolChunk* chunk)
+    /**
+     * @brief Count of a packed pool rounded up so the objects fill a whole multiple of the
+     * alignment in bytes. Objects past get_count() are uninitialised padding that is always
+     * allocated, so SIMD kernels can run over the last partial vector without a scalar tail
+     */
+    inline std::size_t get_padded_count() const
     {
-        m_type_deconstructor(reinterpret_cast<std::byte*>(chunk) + sizeof(ObjectPoolChunk));
-
-        chunk->entity = ECS_ENTITY_DESTROYED;
-        m_freed_locations.push_back(chunk);
+        return _align(m_dense_entities.size(), m_packed_granularity);
     }
 
-    // PERF: Improve so it isn't doing a linear search
+    /**
+     * @brief Contiguous array of every object in a packed pool, nullptr for chunked pools
+     */
     template<typename _T>
-    _T* get_entitys_object(Entity entity)
+    inline _T* data()
     {
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(m_blocks.front());
+        return reinterpret_cast<_T*>(m_packed);
+    }
 
-        while (chunk != nullptr)
-        {
-            if (chunk->entity == entity)
-            {
-                std::byte* byte_data = reinterpret_cast<std::byte*>(chunk);
-                return reinterpret_cast<_T*>(byte_data + sizeof(ObjectPoolChunk));
-            }
+    inline std::byte* data() { return m_packed; }
 
-            chunk = chunk->next;
-        }
+    /**
+     * @brief Whether the entity owns an object in this pool, a handle from an older generation of
+     * the same index never matches
+     */
+    inline bool contains(Entity entity) const
+    {
+        ECS_STATS_INCREMENT(m_lookup_count, 1);
 
-        return nullptr;
+        const std::size_t index = entity.get_index();
+        return index < m_sparse.size() && m_sparse[index] != std::string::npos &&
+               m_dense_entities[m_sparse[index]] == entity;
     }
 
-    std::byte* get_entitys_object(Entity entity)
+    inline std::size_t get_index(Entity entity) const
     {
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(m_blocks.front());
-
-        while (chunk != nullptr)
-        {
-            if (chunk->entity == entity)
-            {
-                std::byte* byte_data = reinterpret_cast<std::byte*>(chunk);
-                return byte_data + sizeof(ObjectPoolChunk);
-            }
-
-            chunk = chunk->next;
-        }
-
-        return nullptr;
+        return contains(entity) ? m_sparse[entity.get_index()] : std::string::npos;
     }
 
-    // PERF: Improve so it isn't doing a linear search
-    ObjectPoolChunk* get_entitys_object_pool_chunk(Entity entity)
+    /**
+     * @brief Stamps every object with the tick clock points to when it's added, when it's marked
+     * with mark_changed() and when it's removed, see Registry::track(). Objects that already exist
+     * are stamped with the current tick, passing nullptr stops tracking
+     */
+    void set_change_tracking(const std::atomic<std::uint64_t>* clock)
     {
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(m_blocks.front());
-
-        while (chunk != nullptr)
+        m_clock = clock;
+        m_removed.clear();
+        if (m_clock == nullptr)
         {
-            if (chunk->entity == entity)
-                return reinterpret_cast<ObjectPoolChunk*>(chunk);
-
-            chunk = chunk->next;
+            m_added_ticks.clear();
+            m_changed_ticks.clear();
+            return;
         }
 
-        return nullptr;
+        m_added_ticks.assign(m_dense_entities.size(), _get_tick());
+        m_changed_ticks.assign(m_dense_entities.size(), _get_tick());
     }
 
-  private:
-    template<typename _T, typename... _Args>
-    _T* _construct(Entity entity, ObjectPoolChunk* chunk, _Args... args)
-    {
-        chunk->entity = entity;
-
-        _T* object =
-            reinterpret_cast<_T*>(reinterpret_cast<std::byte*>(chunk) + sizeof(ObjectPoolChunk));
+    inline bool is_tracking_changes() const { return m_clock != nullptr; }
 
-        new (object) _T(args...);
-        m_next = m_next->next;
+    /**
+     * @brief Tick the object at the dense index was added or last changed at. Pools without
+     * change tracking have no ticks so every object counts as just changed
+     */
+    inline std::uint64_t get_added_tick(std::size_t index) const
+    {
+        return m_clock != nullptr ? m_added_ticks[index] : UINT64_MAX;
+    }
 
-        return object;
+    inline std::uint64_t get_changed_tick(std::size_t index) const
+    {
+        return m_clock != nullptr ? m_changed_ticks[index] : UINT64_MAX;
     }
 
-    std::byte* _construct(Entity entity, ObjectPoolChunk* chunk)
+    /**
+     * @brief Stamps the entity's object with the current tick
+     *
+     * @return false if the entity has no object in this pool
+     */
+    inline bool mark_changed(Entity entity)
     {
-        chunk->entity = entity;
+        if (!contains(entity))
+            return false;
 
-        std::byte* object = reinterpret_cast<std::byte*>(chunk) + sizeof(ObjectPoolChunk);
-        m_type_default_constructor(object);
-        m_next = m_next->next;
+        if (m_clock != nullptr)
+            m_changed_ticks[m_sparse[entity.get_index()]] = _get_tick();
 
-        return object;
+        return true;
     }
 
-    void _allocate_block()
+    /**
+     * @brief Objects removed since change tracking started or clear_removed() last dropped them,
+     * oldest first
+     */
+    inline const std::pmr::vector<ObjectPoolRemoval>& get_removed() const { return m_removed; }
+
+    /**
+     * @brief Drops removals at or before the tick once every system has seen them
+     */
+    void clear_removed(std::uint64_t until)
     {
-        const std::size_t chunk_size = sizeof(ObjectPoolChunk) + m_type_size;
+        auto last = std::find_if(
+            m_removed.begin(), m_removed.end(),
+            [until](const ObjectPoolRemoval& removal) { return removal.tick > until; }
+        );
+        m_removed.erase(m_removed.begin(), last);
+    }
 
-        std::byte* block =
-            static_cast<std::byte*>(std::malloc(sizeof(std::byte) * chunk_size * m_block_size));
-        m_blocks.push_back(block);
-        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(block);
-        chunk->next = reinterpret_cast<ObjectPoolChunk*>(block + chunk_size);
-        chunk->entity = ECS_ENTITY_DESTROYED;
-        chunk->prev = m_next;
+    /**
+     * @brief Exchanges the dense entries at lhs and rhs, moving the objects as well for packed
+     * pools. Pointers to the two objects of a packed pool are swapped afterwards
+     */
+    void swap(std::size_t lhs, std::size_t rhs)
+    {
+        if (lhs == rhs)
+            return;
 
-        for (std::size_t i = 1; i < m_block_size; i++)
+        if (m_layout == ObjectPoolLayout::Packed)
         {
-            ObjectPoolChunk* current = reinterpret_cast<ObjectPoolChunk*>(block + (chunk_size * i));
-            current->next = reinterpret_cast<ObjectPoolChunk*>(block + (chunk_size * (i + 1)));
-            current->prev = chunk;
-            current->entity = ECS_ENTITY_DESTROYED;
-            chunk = current;
+            std::byte* left = m_packed + m_type_size * lhs;
+            std::byte* right = m_packed + m_type_size * rhs;
+            _relocate(_get_swap_slot(), left);
+            _relocate(left, right);
+            _relocate(right, _get_swap_slot());
         }
+        else
+            std::swap(m_dense_chunks[lhs], m_dense_chunks[rhs]);
 
-        chunk->next = nullptr;
-        if (m_next != nullptr)
+        std::swap(m_dense_entities[lhs], m_dense_entities[rhs]);
+        m_sparse[m_dense_entities[lhs].get_index()] = lhs;
+        m_sparse[m_dense_entities[rhs].get_index()] = rhs;
+
+        if (m_clock != nullptr)
         {
-            m_next->next = reinterpret_cast<ObjectPoolChunk*>(block);
-            m_next = m_next->next;
+            std::swap(m_added_ticks[lhs], m_added_ticks[rhs]);
+            std::swap(m_changed_ticks[lhs], m_changed_ticks[rhs]);
+        }
+    }
+
+    /**
+     * @brief Sorts the dense entries with compare(lhs, rhs) taking their current dense indices,
+     * see get_object(). Objects are relocated so they're stored in the new order, chunked pools
+     * reuse the chunks they occupy in address order. Pool pointers are invalid afterwards
+     */
+    template<typename _Compare>
+    void sort(_Compare compare, SortAlgorithm algorithm = SortAlgorithm::Standard)
+    {
+        assert(
+            m_group == nullptr &&
+            "ECS ASSERT (sort()): sorting a pool owned by a group would break the group"
+        );
+
+        std::pmr::vector<std::size_t> order =
+            std::pmr::vector<std::size_t>(m_dense_entities.size(), m_resource);
+        std::iota(order.begin(), order.end(), 0);
+
+        if (algorithm == SortAlgorithm::Insertion)
+        {
+            for (std::size_t i = 1; i < order.size(); i++)
+            {
+                const std::size_t index = order[i];
+                std::size_t j = i;
+                for (; j > 0 && compare(index, order[j - 1]); j--)
+                    order[j] = order[j - 1];
+
+                order[j] = index;
+            }
+        }
+        else
+            std::sort(order.begin(), order.end(), compare);
+
+        _reorder(order);
+    }
+
+    /**
+     * @brief Sorts the pool so the entities it shares with other come first in the same order as
+     * in other, the remaining entities keep their relative order after them
+     */
+    void sort_as(const ObjectPool& other) { sort_as(other.get_dense_entities()); }
+
+    /**
+     * @brief Same as sort_as(other) with the order given by a list of distinct entities
+     */
+    void sort_as(std::span<const Entity> entities)
+    {
+        assert(
+            m_group == nullptr &&
+            "ECS ASSERT (sort_as()): sorting a pool owned by a group would break the group"
+        );
+
+        const std::size_t count = m_dense_entities.size();
+        std::pmr::vector<std::size_t> order = std::pmr::vector<std::size_t>(m_resource);
+        std::pmr::vector<bool> placed = std::pmr::vector<bool>(count, false, m_resource);
+        order.reserve(count);
+        for (Entity entity : entities)
+        {
+            if (contains(entity))
+            {
+                order.push_back(m_sparse[entity.get_index()]);
+                placed[order.back()] = true;
+            }
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (!placed[i])
+                order.push_back(i);
+        }
+
+        // Pools that already match are common when sorting every frame, nothing has to move
+        for (std::size_t i = 0; i < count; i++)
+        {
+            if (order[i] != i)
+            {
+                _reorder(order);
+                return;
+            }
+        }
+    }
+
+    /**
+     * @brief Moves every object of other into this pool and leaves other empty, remap maps the
+     * index of each entity of other to the entity it becomes here. Chunked pools with the same
+     * block size and an equal memory resource splice the blocks of other onto the chunk chain
+     * so no object moves, otherwise the objects are relocated in dense order
+     */
+    void merge(ObjectPool& other, std::span<const Entity> remap)
+    {
+        assert(
+            m_type_hash == other.m_type_hash && m_type_size == other.m_type_size &&
+            "ECS ASSERT (merge()): pools store different types"
+        );
+
+        const std::size_t count = other.m_dense_entities.size();
+        m_dense_entities.reserve(get_count() + count);
+        if (m_layout == ObjectPoolLayout::Chunked && other.m_layout == ObjectPoolLayout::Chunked &&
+            m_block_size == other.m_block_size && m_chunk_stride == other.m_chunk_stride &&
+            m_chunk_offset == other.m_chunk_offset && *m_resource == *other.m_resource)
+        {
+            _splice(other, remap);
+            return;
+        }
+
+        if (m_layout == ObjectPoolLayout::Packed && other.m_layout == ObjectPoolLayout::Packed)
+        {
+            reserve(get_count() + count);
+            if (count > 0)
+                _relocate(_next_packed_slot(), other.m_packed, count);
+
+            for (Entity entity : other.m_dense_entities)
+                _index_insert(remap[entity.get_index()], nullptr);
+        }
+        else
+        {
+            reserve(get_count() + count);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const Entity entity = remap[other.m_dense_entities[i].get_index()];
+                ObjectPoolChunk* chunk = nullptr;
+                std::byte* target = nullptr;
+                if (m_layout == ObjectPoolLayout::Packed)
+                    target = _next_packed_slot();
+                else
+                {
+                    chunk = _next_free_chunk();
+                    chunk->entity = entity;
+                    target = reinterpret_cast<std::byte*>(chunk) + m_chunk_offset;
+                }
+
+                _relocate(target, other.get_object(i));
+                _index_insert(entity, chunk);
+            }
+        }
+
+        // The objects have been moved out, other keeps its storage with nothing alive in it
+        for (ObjectPoolChunk* chunk : other.m_dense_chunks)
+        {
+            chunk->entity = ECS_ENTITY_DESTROYED;
+            other.m_freed_locations.push_back(chunk);
+        }
+        other._clear_index();
+    }
+
+    /**
+     * @brief Owning group the pool belongs to, see Registry::group()
+     */
+    inline ObjectPoolGroup* get_group() const { return m_group; }
+    inline void set_group(ObjectPoolGroup* group) { m_group = group; }
+
+    /**
+     * @brief Counts objects visited by a view driven by this pool, only when ECS_ENABLE_STATS is
+     * defined
+     */
+    inline void record_iterations([[maybe_unused]] std::size_t count) const
+    {
+        ECS_STATS_INCREMENT(m_iteration_count, count);
+    }
+
+    ObjectPoolStats get_stats() const
+    {
+        ObjectPoolStats stats = {};
+        stats.count = get_count();
+        stats.capacity = get_capacity();
+        stats.free_count = m_freed_locations.size();
+        stats.block_count = m_blocks.size();
+        stats.used_bytes = m_type_size * get_count();
+
+        if (m_layout == ObjectPoolLayout::Packed)
+            stats.reserved_bytes = m_type_size * m_packed_capacity;
+        else
+        {
+            for (const Allocation& allocation : m_allocations)
+                stats.reserved_bytes += allocation.size;
+        }
+
+        const std::size_t touched = stats.count + stats.free_count;
+        if (touched > 0)
+            stats.fragmentation = static_cast<double>(stats.free_count) / touched;
+
+#ifdef ECS_ENABLE_STATS
+        stats.lookups = m_lookup_count.load(std::memory_order_relaxed);
+        stats.iterations = m_iteration_count.load(std::memory_order_relaxed);
+#endif
+        return stats;
+    }
+
+    inline void reset_stats()
+    {
+#ifdef ECS_ENABLE_STATS
+        m_lookup_count.store(0, std::memory_order_relaxed);
+        m_iteration_count.store(0, std::memory_order_relaxed);
+#endif
+    }
+
+    /**
+     * @brief Object stored at the dense index, see get_dense_entities()
+     */
+    inline std::byte* get_object(std::size_t index)
+    {
+        if (m_layout == ObjectPoolLayout::Packed)
+            return m_packed + m_type_size * index;
+
+        return reinterpret_cast<std::byte*>(m_dense_chunks[index]) + m_chunk_offset;
+    }
+
+    template<typename _T, typename... _Args>
+    _T* malloc(Entity entity, _Args&&... args)
+    {
+        _check_type<_T>("malloc");
+
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            new (reinterpret_cast<_T*>(_next_packed_slot())) _T(std::forward<_Args>(args)...);
+            _index_insert(entity, nullptr);
+            return reinterpret_cast<_T*>(get_object(m_sparse[entity.get_index()]));
+        }
+
+        ObjectPoolChunk* chunk = _next_free_chunk();
+        _T* object = _construct<_T>(entity, chunk, std::forward<_Args>(args)...);
+        _index_insert(entity, chunk);
+        return object;
+    }
+
+    std::byte* malloc(Entity entity)
+    {
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            m_type_default_constructor(_next_packed_slot());
+            _index_insert(entity, nullptr);
+            return get_object(m_sparse[entity.get_index()]);
+        }
+
+        ObjectPoolChunk* chunk = _next_free_chunk();
+        std::byte* object = _construct(entity, chunk);
+        _index_insert(entity, chunk);
+        return object;
+    }
+
+    /**
+     * @brief Copy constructs prototype for every entity with the type checked once and the
+     * storage reserved up front
+     */
+    template<typename _T>
+    void malloc(std::span<const Entity> entities, const _T& prototype)
+    {
+        _check_type<_T>("malloc");
+        reserve(get_count() + entities.size());
+
+        for (Entity entity : entities)
+        {
+            if (m_layout == ObjectPoolLayout::Packed)
+            {
+                new (reinterpret_cast<_T*>(_next_packed_slot())) _T(prototype);
+                _index_insert(entity, nullptr);
+            }
+            else
+            {
+                ObjectPoolChunk* chunk = _next_free_chunk();
+                _construct<_T>(entity, chunk, prototype);
+                _index_insert(entity, chunk);
+            }
+        }
+    }
+
+    /**
+     * @brief Creates a copy of prototype for the entity through the type erased copy constructor,
+     * prototype may be an object of this pool
+     */
+    std::byte* copy(Entity entity, const std::byte* prototype)
+    {
+        return _copy(std::span<const Entity>(&entity, 1), prototype);
+    }
+
+    /**
+     * @brief Creates a copy of prototype for every entity, the storage is reserved up front
+     */
+    void copy(std::span<const Entity> entities, const std::byte* prototype)
+    {
+        _copy(entities, prototype);
+    }
+
+    /**
+     * @brief Creates an object for every entity from the trivially copyable objects stored one
+     * after the other in payload, a packed pool copies all of them with a single std::memcpy
+     */
+    void load(std::span<const Entity> entities, const std::byte* payload)
+    {
+        assert(
+            m_type_trivially_copyable &&
+            "ECS ASSERT: only trivially copyable objects can be loaded from raw bytes"
+        );
+
+        reserve(get_count() + entities.size());
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            if (!entities.empty())
+                std::memcpy(_next_packed_slot(), payload, m_type_size * entities.size());
+
+            for (Entity entity : entities)
+                _index_insert(entity, nullptr);
+            return;
+        }
+
+        for (std::size_t i = 0; i < entities.size(); i++)
+        {
+            ObjectPoolChunk* chunk = _next_free_chunk();
+            chunk->entity = entities[i];
+            std::memcpy(
+                reinterpret_cast<std::byte*>(chunk) + m_chunk_offset, payload + m_type_size * i,
+                m_type_size
+            );
+            _index_insert(entities[i], chunk);
+        }
+    }
+
+    /**
+     * @brief Uses data, holding capacity trivially copyable objects of which the first
+     * entities.size() belong to the entities, as the packed array of an empty packed pool
+     * without copying it. The pool never deallocates data, it has to stay valid until the pool
+     * is destroyed or the array grows past capacity
+     *
+     * @return false, leaving the pool unchanged, when the pool isn't an empty packed pool of
+     * trivially copyable objects or data is misaligned or too small
+     */
+    bool adopt(std::span<const Entity> entities, std::byte* data, std::size_t capacity)
+    {
+        capacity = capacity / m_packed_granularity * m_packed_granularity;
+        if (m_layout != ObjectPoolLayout::Packed || !m_type_trivially_copyable ||
+            get_count() > 0 || entities.size() > capacity ||
+            reinterpret_cast<std::uintptr_t>(data) % m_type_alignment != 0)
+            return false;
+
+        _release_packed();
+        m_packed = data;
+        m_packed_capacity = capacity;
+        m_packed_adopted = true;
+
+        m_dense_entities.reserve(entities.size());
+        for (Entity entity : entities)
+            _index_insert(entity, nullptr);
+
+        return true;
+    }
+
+    /**
+     * @brief Makes sure count objects fit in the pool without allocating again. Chunked pools
+     * allocate all of the missing blocks in a single allocation
+     */
+    void reserve(std::size_t count)
+    {
+        m_dense_entities.reserve(count);
+
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            if (count > m_packed_capacity)
+                _reallocate_packed(count);
+            return;
+        }
+
+        m_dense_chunks.reserve(count);
+        const std::size_t capacity = m_blocks.size() * m_block_size;
+        if (count > capacity)
+            _allocate_block((count - capacity + m_block_size - 1) / m_block_size);
+    }
+
+    inline std::size_t get_capacity() const
+    {
+        if (m_layout == ObjectPoolLayout::Packed)
+            return m_packed_capacity;
+
+        return m_blocks.size() * m_block_size;
+    }
+
+    template<typename _T>
+    void free(_T* type)
+    {
+        _check_type<_T>("free");
+
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            free(reinterpret_cast<std::byte*>(type));
+            return;
+        }
+
+        type->~_T();
+
+        ObjectPoolChunk* chunk = reinterpret_cast<ObjectPoolChunk*>(
+            reinterpret_cast<std::byte*>(type) - m_chunk_offset
+        );
+        _release_chunk(chunk);
+    }
+
+    void free(std::byte* ptr)
+    {
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            _release_packed_slot(static_cast<std::size_t>(ptr - m_packed) / m_type_size);
+            return;
+        }
+
+        free(reinterpret_cast<ObjectPoolChunk*>(ptr - m_chunk_offset));
+    }
+
+    void free(ObjectPoolChunk* chunk)
+    {
+        if (m_type_deconstructor != nullptr)
+            m_type_deconstructor(reinterpret_cast<std::byte*>(chunk) + m_chunk_offset);
+
+        _release_chunk(chunk);
+    }
+
+    /**
+     * @brief Destroys the object owned by the entity if there is one
+     *
+     * @return true if an object was destroyed
+     */
+    bool free(Entity entity)
+    {
+        if (!contains(entity))
+            return false;
+
+        if (m_layout == ObjectPoolLayout::Packed)
+            _release_packed_slot(m_sparse[entity.get_index()]);
+        else
+            free(m_dense_chunks[m_sparse[entity.get_index()]]);
+
+        return true;
+    }
+
+    template<typename _T>
+    _T* get_entitys_object(Entity entity)
+    {
+        return reinterpret_cast<_T*>(get_entitys_object(entity));
+    }
+
+    std::byte* get_entitys_object(Entity entity)
+    {
+        if (!contains(entity))
+            return nullptr;
+
+        return get_object(m_sparse[entity.get_index()]);
+    }
+
+    /**
+     * @brief Chunk owned by the entity, always nullptr for packed pools as they have no chunks
+     */
+    ObjectPoolChunk* get_entitys_object_pool_chunk(Entity entity)
+    {
+        if (m_layout == ObjectPoolLayout::Packed || !contains(entity))
+            return nullptr;
+
+        return m_dense_chunks[m_sparse[entity.get_index()]];
+    }
+
+    /**
+     * @brief Moves every object into as few blocks as needed, in order of entity index, and
+     * releases all of the old blocks. Packed pools are sorted the same way and shrunk to fit.
+     * Pointers to objects of the pool are invalid afterwards. Pools owned by a group keep their
+     * dense order so the group stays aligned
+     *
+     * The new blocks are allocated before the old ones are released, use compact(budget) when
+     * that peak or the cost of moving every object at once is too high
+     */
+    void compact()
+    {
+        const std::pmr::vector<std::size_t> order = _get_entity_order();
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            _reallocate_packed(m_dense_entities.size(), order);
+            return;
+        }
+
+        std::pmr::vector<Allocation> allocations = std::move(m_allocations);
+        std::pmr::vector<ObjectPoolChunk*> chunks = std::move(m_dense_chunks);
+        m_allocations = std::pmr::vector<Allocation>(m_resource);
+        m_dense_chunks = std::pmr::vector<ObjectPoolChunk*>(m_resource);
+        m_blocks.clear();
+        m_blocks.shrink_to_fit();
+        m_freed_locations.clear();
+        m_freed_locations.shrink_to_fit();
+        m_next = nullptr;
+        m_tail = nullptr;
+
+        const std::size_t count = m_dense_entities.size();
+        if (count > 0)
+            _allocate_block((count + m_block_size - 1) / m_block_size);
+
+        m_dense_chunks.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            ObjectPoolChunk* source = chunks[order[i]];
+            ObjectPoolChunk* target = m_next;
+            m_next = m_next->next;
+
+            _relocate(
+                reinterpret_cast<std::byte*>(target) + m_chunk_offset,
+                reinterpret_cast<std::byte*>(source) + m_chunk_offset
+            );
+            target->entity = source->entity;
+            m_dense_chunks.push_back(target);
+        }
+
+        _apply_entity_order(order);
+        for (const Allocation& allocation : allocations)
+            _deallocate(allocation.data, allocation.size);
+    }
+
+    /**
+     * @brief Incremental compaction that stops once budget has passed. Objects of the most
+     * recently allocated blocks are moved into freed chunks of older blocks and the newest
+     * allocation is released as soon as it's empty. Unlike compact() objects are not sorted and
+     * nothing new is allocated, packed pools have no partial step so they're fully compacted
+     *
+     * @return true when nothing is left to compact, false when the budget ran out first
+     */
+    bool compact(std::chrono::nanoseconds budget)
+    {
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            compact();
+            return true;
+        }
+
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        std::pmr::vector<ObjectPoolChunk*> moved = std::pmr::vector<ObjectPoolChunk*>(m_resource);
+
+        while (!m_allocations.empty())
+        {
+            const Allocation last = m_allocations.back();
+            auto inside = [&last](const ObjectPoolChunk* chunk)
+            {
+                const std::byte* address = reinterpret_cast<const std::byte*>(chunk);
+                return address >= last.data && address < last.data + last.size;
+            };
+
+            // Freed chunks of the last allocation go first so targets are popped from the back
+            auto outside =
+                std::stable_partition(m_freed_locations.begin(), m_freed_locations.end(), inside);
+            const std::size_t inside_count =
+                static_cast<std::size_t>(outside - m_freed_locations.begin());
+
+            moved.clear();
+            for (std::size_t offset = 0; offset < last.size; offset += m_chunk_stride)
+            {
+                ObjectPoolChunk* source = reinterpret_cast<ObjectPoolChunk*>(last.data + offset);
+                if (source->entity == ECS_ENTITY_DESTROYED)
+                    continue;
+
+                if (m_freed_locations.size() == inside_count)
+                {
+                    m_freed_locations.insert(m_freed_locations.end(), moved.begin(), moved.end());
+                    return true;
+                }
+
+                ObjectPoolChunk* target = m_freed_locations.back();
+                m_freed_locations.pop_back();
+
+                _relocate(
+                    reinterpret_cast<std::byte*>(target) + m_chunk_offset,
+                    reinterpret_cast<std::byte*>(source) + m_chunk_offset
+                );
+                target->entity = source->entity;
+                source->entity = ECS_ENTITY_DESTROYED;
+                m_dense_chunks[m_sparse[target->entity.get_index()]] = target;
+                moved.push_back(source);
+
+                if (moved.size() % 16 == 0 && std::chrono::steady_clock::now() >= deadline)
+                {
+                    m_freed_locations.insert(m_freed_locations.end(), moved.begin(), moved.end());
+                    return false;
+                }
+            }
+
+            m_freed_locations.erase(
+                m_freed_locations.begin(), m_freed_locations.begin() + inside_count
+            );
+            _release_last_allocation();
+
+            if (std::chrono::steady_clock::now() >= deadline)
+                return m_allocations.empty();
+        }
+
+        return true;
+    }
+
+  private:
+    struct Allocation
+    {
+        std::byte* data = nullptr;
+        std::size_t size = 0;
+    };
+
+  private:
+    /**
+     * @brief Makes sure _T is the type the pool was created for. The hash is computed at compile
+     * time so this is a single integer comparison, and it's compiled out when NDEBUG is defined
+     */
+    template<typename _T>
+    inline void _check_type([[maybe_unused]] const char* function_name) const
+    {
+        [[maybe_unused]] constexpr std::uint64_t hash = type_descriptor::get_hash<_T>();
+        ECS_TYPE_CONTRADICTION_ASSERT(
+            hash == m_type_hash, m_type_name,
+            std::string(
+                type_descriptor::get_name<_T>().data(), type_descriptor::get_name<_T>().size()
+            ),
+            function_name
+        );
+    }
+
+    template<typename _T, typename... _Args>
+    _T* _construct(Entity entity, ObjectPoolChunk* chunk, _Args&&... args)
+    {
+        chunk->entity = entity;
+
+        _T* object =
+            reinterpret_cast<_T*>(reinterpret_cast<std::byte*>(chunk) + m_chunk_offset);
+
+        new (object) _T(std::forward<_Args>(args)...);
+        return object;
+    }
+
+    std::byte* _construct(Entity entity, ObjectPoolChunk* chunk)
+    {
+        chunk->entity = entity;
+
+        std::byte* object = reinterpret_cast<std::byte*>(chunk) + m_chunk_offset;
+        m_type_default_constructor(object);
+        return object;
+    }
+
+    /**
+     * @brief Pops a previously freed chunk if there is one, otherwise takes the next untouched
+     * chunk and allocates a new block when all of them are used
+     */
+    ObjectPoolChunk* _next_free_chunk()
+    {
+        if (m_freed_locations.size() > 0)
+        {
+            ObjectPoolChunk* chunk = m_freed_locations.back();
+            m_freed_locations.pop_back();
+            return chunk;
+        }
+        else if (m_next == nullptr)
+            _allocate_block();
+
+        ObjectPoolChunk* chunk = m_next;
+        m_next = m_next->next;
+        return chunk;
+    }
+
+    void _release_chunk(ObjectPoolChunk* chunk)
+    {
+        if (m_group != nullptr)
+            _group_remove(chunk->entity);
+
+        _index_erase(chunk->entity);
+        chunk->entity = ECS_ENTITY_DESTROYED;
+        m_freed_locations.push_back(chunk);
+    }
+
+    /**
+     * @brief Returns the uninitialised slot after the last object of a packed pool, growing the
+     * array when it is full
+     */
+    std::byte* _next_packed_slot()
+    {
+        std::size_t count = m_dense_entities.size();
+        if (count == m_packed_capacity)
+            _reallocate_packed(m_packed_capacity > 0 ? m_packed_capacity * 2 : m_block_size);
+
+
+        return m_packed + m_type_size * count;
+    }
+
+    /**
+     * @brief Destroys the object of a packed pool at the dense index and moves the last object
+     * into its slot so the array stays without gaps
+     */
+    void _release_packed_slot(std::size_t index)
+    {
+        if (m_group != nullptr)
+        {
+            const Entity entity = m_dense_entities[index];
+            _group_remove(entity);
+            index = m_sparse[entity.get_index()];
+        }
+
+        std::byte* target = m_packed + m_type_size * index;
+        if (m_type_deconstructor != nullptr)
+            m_type_deconstructor(target);
+
+        std::size_t last = m_dense_entities.size() - 1;
+        if (index != last)
+            _relocate(target, m_packed + m_type_size * last);
+
+        _index_erase(m_dense_entities[index]);
+    }
+
+    /**
+     * @brief The capacity is rounded up to the padding granularity so the padded tail of
+     * get_padded_count() is always inside of the array
+     */
+    void _reallocate_packed(std::size_t capacity)
+    {
+        capacity = _align(capacity, m_packed_granularity);
+
+        std::byte* packed = _allocate(m_type_size * capacity);
+        _relocate(packed, m_packed, m_dense_entities.size());
+
+        _release_packed();
+        m_packed = packed;
+        m_packed_capacity = capacity;
+    }
+
+    /**
+     * @brief Same as above except object i of the new array is the object at dense index
+     * order[i], the dense entities are reordered to match
+     */
+    void _reallocate_packed(std::size_t capacity, const std::pmr::vector<std::size_t>& order)
+    {
+        capacity = _align(capacity, m_packed_granularity);
+
+        std::byte* packed = capacity > 0 ? _allocate(m_type_size * capacity) : nullptr;
+        for (std::size_t i = 0; i < m_dense_entities.size(); i++)
+            _relocate(packed + m_type_size * i, m_packed + m_type_size * order[i]);
+
+        _release_packed();
+        m_packed = packed;
+        m_packed_capacity = capacity;
+        _apply_entity_order(order);
+    }
+
+    /**
+     * @brief Dense indices sorted by the index of the entity they belong to
+     */
+    std::pmr::vector<std::size_t> _get_entity_order() const
+    {
+        std::pmr::vector<std::size_t> order =
+            std::pmr::vector<std::size_t>(m_dense_entities.size(), m_resource);
+        std::iota(order.begin(), order.end(), 0);
+        if (m_group != nullptr)
+            return order;
+
+        std::sort(
+            order.begin(), order.end(),
+            [this](std::size_t lhs, std::size_t rhs)
+            { return m_dense_entities[lhs].get_index() < m_dense_entities[rhs].get_index(); }
+        );
+
+        return order;
+    }
+
+    /**
+     * @brief Reorders the dense entities so entry i is the entity previously at order[i]. Chunked
+     * pools have to have m_dense_chunks in the new order already
+     */
+    void _apply_entity_order(const std::pmr::vector<std::size_t>& order)
+    {
+        std::pmr::vector<Entity> entities = std::pmr::vector<Entity>(m_resource);
+        entities.reserve(order.size());
+        for (std::size_t i = 0; i < order.size(); i++)
+        {
+            entities.push_back(m_dense_entities[order[i]]);
+            m_sparse[entities.back().get_index()] = i;
+        }
+
+        m_dense_entities = std::move(entities);
+        if (m_clock != nullptr)
+        {
+            _apply_order(m_added_ticks, order);
+            _apply_order(m_changed_ticks, order);
+        }
+    }
+
+    void _apply_order(
+        std::pmr::vector<std::uint64_t>& ticks, const std::pmr::vector<std::size_t>& order
+    )
+    {
+        std::pmr::vector<std::uint64_t> ordered = std::pmr::vector<std::uint64_t>(m_resource);
+        ordered.reserve(order.size());
+        for (std::size_t index : order)
+            ordered.push_back(ticks[index]);
+
+        ticks = std::move(ordered);
+    }
+
+    inline std::uint64_t _get_tick() const { return m_clock->load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Moves the object at dense index order[i] to dense index i. Packed slots are the
+     * array itself, chunked pools use the chunks they occupy sorted by address as the slots so
+     * the objects end up in ascending memory order
+     */
+    void _reorder(const std::pmr::vector<std::size_t>& order)
+    {
+        const std::size_t count = order.size();
+        std::pmr::vector<std::size_t> source = order;
+        std::pmr::vector<std::byte*> slots = std::pmr::vector<std::byte*>(count, m_resource);
+
+        if (m_layout == ObjectPoolLayout::Packed)
+        {
+            for (std::size_t i = 0; i < count; i++)
+                slots[i] = m_packed + m_type_size * i;
+        }
+        else
+        {
+            std::pmr::vector<std::size_t> by_address =
+                std::pmr::vector<std::size_t>(count, m_resource);
+            std::iota(by_address.begin(), by_address.end(), 0);
+            std::sort(
+                by_address.begin(), by_address.end(),
+                [this](std::size_t lhs, std::size_t rhs)
+                { return std::less<ObjectPoolChunk*>()(m_dense_chunks[lhs], m_dense_chunks[rhs]); }
+            );
+
+            std::pmr::vector<std::size_t> rank = std::pmr::vector<std::size_t>(count, m_resource);
+            for (std::size_t i = 0; i < count; i++)
+            {
+                rank[by_address[i]] = i;
+                slots[i] =
+                    reinterpret_cast<std::byte*>(m_dense_chunks[by_address[i]]) + m_chunk_offset;
+            }
+
+            for (std::size_t i = 0; i < count; i++)
+                source[i] = rank[order[i]];
+        }
+
+        // Follow every cycle of the permutation, fixed points cost nothing
+        for (std::size_t start = 0; start < count; start++)
+        {
+            if (source[start] == start)
+                continue;
+
+            _relocate(_get_swap_slot(), slots[start]);
+            std::size_t current = start;
+            while (source[current] != start)
+            {
+                const std::size_t next = source[current];
+                _relocate(slots[current], slots[next]);
+                source[current] = current;
+                current = next;
+            }
+
+            _relocate(slots[current], _get_swap_slot());
+            source[current] = current;
+        }
+
+        if (m_layout == ObjectPoolLayout::Chunked)
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                m_dense_chunks[i] = reinterpret_cast<ObjectPoolChunk*>(slots[i] - m_chunk_offset);
+                m_dense_chunks[i]->entity = m_dense_entities[order[i]];
+            }
+        }
+
+        _apply_entity_order(order);
+    }
+
+    /**
+     * @brief Chunked merge(), chunks after m_next have to be untouched so the untouched chunks of
+     * this pool are handed to the free list and other's chain is appended after m_tail
+     */
+    void _splice(ObjectPool& other, std::span<const Entity> remap)
+    {
+        for (ObjectPoolChunk* chunk = m_next; chunk != nullptr; chunk = chunk->next)
+            m_freed_locations.push_back(chunk);
+        m_freed_locations.insert(
+            m_freed_locations.end(), other.m_freed_locations.begin(), other.m_freed_locations.end()
+        );
+
+        if (!other.m_allocations.empty())
+        {
+            ObjectPoolChunk* first =
+                reinterpret_cast<ObjectPoolChunk*>(other.m_allocations.front().data);
+            first->prev = m_tail;
+            if (m_tail != nullptr)
+                m_tail->next = first;
+
+            m_tail = other.m_tail;
+            m_next = other.m_next;
+        }
+        else
+            m_next = nullptr;
+
+        m_allocations.insert(
+            m_allocations.end(), other.m_allocations.begin(), other.m_allocations.end()
+        );
+        m_blocks.insert(m_blocks.end(), other.m_blocks.begin(), other.m_blocks.end());
+
+        m_dense_chunks.reserve(m_dense_chunks.size() + other.m_dense_chunks.size());
+        for (ObjectPoolChunk* chunk : other.m_dense_chunks)
+        {
+            chunk->entity = remap[chunk->entity.get_index()];
+            _index_insert(chunk->entity, chunk);
+        }
+
+        other.m_allocations.clear();
+        other.m_blocks.clear();
+        other.m_freed_locations.clear();
+        other.m_next = nullptr;
+        other.m_tail = nullptr;
+        other._clear_index();
+    }
+
+    /**
+     * @brief Forgets every entity without touching the objects, the caller is responsible for
+     * them
+     */
+    void _clear_index()
+    {
+        m_sparse.clear();
+        m_dense_entities.clear();
+        m_dense_chunks.clear();
+        m_added_ticks.clear();
+        m_changed_ticks.clear();
+    }
+
+    inline std::byte* _get_swap_slot()
+    {
+        if (m_swap_slot == nullptr)
+            m_swap_slot = _allocate(m_type_size);
+
+        return m_swap_slot;
+    }
+
+    /**
+     * @brief Frees the packed array unless it was adopted, see adopt()
+     */
+    inline void _release_packed()
+    {
+        if (!m_packed_adopted)
+            _deallocate(m_packed, m_type_size * m_packed_capacity);
+
+        m_packed = nullptr;
+        m_packed_capacity = 0;
+        m_packed_adopted = false;
+    }
+
+    inline void _relocate(std::byte* target, std::byte* source)
+    {
+        if (m_type_relocator != nullptr)
+            m_type_relocator(target, source);
+        else
+            std::memcpy(target, source, m_type_size);
+    }
+
+    /**
+     * @brief Relocates count objects stored next to each other, trivially relocatable objects
+     * are moved with a single std::memcpy
+     */
+    inline void _relocate(std::byte* target, std::byte* source, std::size_t count)
+    {
+        if (m_type_relocator == nullptr)
+        {
+            if (count > 0)
+                std::memcpy(target, source, m_type_size * count);
+            return;
+        }
+
+        for (std::size_t i = 0; i < count; i++)
+            m_type_relocator(target + m_type_size * i, source + m_type_size * i);
+    }
+
+    inline void _copy_construct(std::byte* target, const std::byte* source)
+    {
+        if (m_type_copy_constructor != nullptr)
+            m_type_copy_constructor(target, source);
+        else
+            std::memcpy(target, source, m_type_size);
+    }
+
+    /**
+     * @brief Copies prototype for every entity and returns the last copy. A prototype inside of
+     * the packed array is found again through its entity, growing the array or a group swap moves
+     * it
+     */
+    std::byte* _copy(std::span<const Entity> entities, const std::byte* prototype)
+    {
+        assert(
+            is_copyable() &&
+            "ECS ASSERT: pool has no copy constructor and is not trivially copyable"
+        );
+
+        Entity owner = ECS_ENTITY_DESTROYED;
+        if (m_packed != nullptr && prototype >= m_packed &&
+            prototype < m_packed + m_type_size * m_dense_entities.size())
+            owner = m_dense_entities[static_cast<std::size_t>(prototype - m_packed) / m_type_size];
+
+        reserve(get_count() + entities.size());
+
+        std::byte* object = nullptr;
+        for (Entity entity : entities)
+        {
+            if (m_layout == ObjectPoolLayout::Packed)
+            {
+                if (owner != ECS_ENTITY_DESTROYED)
+                    prototype = get_object(m_sparse[owner.get_index()]);
+
+                _copy_construct(_next_packed_slot(), prototype);
+                _index_insert(entity, nullptr);
+                object = get_object(m_sparse[entity.get_index()]);
+            }
+            else
+            {
+                ObjectPoolChunk* chunk = _next_free_chunk();
+                chunk->entity = entity;
+                object = reinterpret_cast<std::byte*>(chunk) + m_chunk_offset;
+                _copy_construct(object, prototype);
+                _index_insert(entity, chunk);
+            }
+        }
+
+        return object;
+    }
+
+    void _index_insert(Entity entity, ObjectPoolChunk* chunk)
+    {
+        const std::size_t index = entity.get_index();
+        if (index >= m_sparse.size())
+            m_sparse.resize(index + 1, std::string::npos);
+
+        m_sparse[index] = m_dense_entities.size();
+        m_dense_entities.push_back(entity);
+        if (m_layout == ObjectPoolLayout::Chunked)
+            m_dense_chunks.push_back(chunk);
+
+        if (m_clock != nullptr)
+        {
+            m_added_ticks.push_back(_get_tick());
+            m_changed_ticks.push_back(m_added_ticks.back());
+        }
+
+        if (m_group != nullptr)
+            _group_insert(entity);
+    }
+
+    /**
+     * @brief Keeps the owning group aligned, defined after ObjectPoolGroup
+     */
+    inline void _group_insert(Entity entity);
+    inline void _group_remove(Entity entity);
+
+    /**
+     * @brief Removes the entity from the sparse set by moving the last dense entry into its slot
+     */
+    void _index_erase(Entity entity)
+    {
+        std::size_t index = m_sparse[entity.get_index()];
+        Entity last = m_dense_entities.back();
+
+        m_dense_entities[index] = last;
+        m_sparse[last.get_index()] = index;
+        m_dense_entities.pop_back();
+        m_sparse[entity.get_index()] = std::string::npos;
+
+        if (m_layout == ObjectPoolLayout::Chunked)
+        {
+            m_dense_chunks[index] = m_dense_chunks.back();
+            m_dense_chunks.pop_back();
+        }
+
+        if (m_clock != nullptr)
+        {
+            m_added_ticks[index] = m_added_ticks.back();
+            m_added_ticks.pop_back();
+            m_changed_ticks[index] = m_changed_ticks.back();
+            m_changed_ticks.pop_back();
+            m_removed.push_back(ObjectPoolRemoval{entity, _get_tick()});
+        }
+    }
+
+    static constexpr std::size_t _align(std::size_t value, std::size_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    inline std::size_t _get_allocation_alignment() const
+    {
+        return std::max(m_type_alignment, alignof(std::max_align_t));
+    }
+
+    inline std::byte* _allocate(std::size_t size)
+    {
+        return static_cast<std::byte*>(m_resource->allocate(size, _get_allocation_alignment()));
+    }
+
+    inline void _deallocate(std::byte* data, std::size_t size)
+    {
+        if (data != nullptr)
+            m_resource->deallocate(data, size, _get_allocation_alignment());
+    }
+
+    /**
+     * @brief Allocates block_count blocks in a single allocation and appends their chunks to the
+     * end of the chunk chain
+     */
+    void _allocate_block(std::size_t block_count = 1)
+    {
+        const std::size_t chunk_size = m_chunk_stride;
+        const std::size_t block_bytes = chunk_size * m_block_size;
+
+        std::byte* allocation = _allocate(block_bytes * block_count);
+        m_allocations.push_back(Allocation{allocation, block_bytes * block_count});
+
+        ObjectPoolChunk* first = reinterpret_cast<ObjectPoolChunk*>(allocation);
+        ObjectPoolChunk* prev = m_tail;
+        for (std::size_t i = 0; i < m_block_size * block_count; i++)
+        {
+            if (i % m_block_size == 0)
+                m_blocks.push_back(allocation + chunk_size * i);
+
+            ObjectPoolChunk* current =
+                reinterpret_cast<ObjectPoolChunk*>(allocation + (chunk_size * i));
+            current->next = nullptr;
+            current->prev = prev;
+            current->entity = ECS_ENTITY_DESTROYED;
+
+            if (prev != nullptr)
+                prev->next = current;
+            prev = current;
+        }
+
+        m_tail = prev;
+        if (m_next == nullptr)
+            m_next = first;
+    }
+
+    /**
+     * @brief Deallocates the newest allocation once none of its chunks are alive and cuts its
+     * blocks off the end of the chunk chain
+     */
+    void _release_last_allocation()
+    {
+        const Allocation last = m_allocations.back();
+        auto inside = [&last](const void* address)
+        {
+            return static_cast<const std::byte*>(address) >= last.data &&
+                   static_cast<const std::byte*>(address) < last.data + last.size;
+        };
+
+        while (!m_blocks.empty() && inside(m_blocks.back()))
+            m_blocks.pop_back();
+
+        if (m_next == nullptr || inside(m_next))
+            m_next = nullptr;
+
+        m_tail = reinterpret_cast<ObjectPoolChunk*>(last.data)->prev;
+        if (m_tail != nullptr)
+            m_tail->next = nullptr;
+
+        _deallocate(last.data, last.size);
+        m_allocations.pop_back();
+    }
+
+  protected:
+    const std::string m_type_name = "";
+    const std::size_t m_type_size = 0;
+    const std::uint64_t m_type_hash = 0;
+    const std::size_t m_block_size = 0;
+    const ObjectPoolLayout m_layout = ObjectPoolLayout::Chunked;
+    const std::size_t m_type_alignment = alignof(std::max_align_t);
+    const std::size_t m_chunk_offset = sizeof(ObjectPoolChunk);
+    const std::size_t m_chunk_stride = sizeof(ObjectPoolChunk);
+    const std::size_t m_packed_granularity = 1;
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+    std::pmr::vector<std::byte*> m_blocks = {};
+    ObjectPoolChunk* m_next = nullptr;
+    ObjectPoolChunk* m_tail = nullptr;
+    std::pmr::vector<Allocation> m_allocations = {};
+    std::pmr::vector<ObjectPoolChunk*> m_freed_locations = {};
+    std::pmr::vector<std::size_t> m_sparse = {};
+    std::pmr::vector<Entity> m_dense_entities = {};
+    std::pmr::vector<ObjectPoolChunk*> m_dense_chunks = {};
+    const std::atomic<std::uint64_t>* m_clock = nullptr;
+    std::pmr::vector<std::uint64_t> m_added_ticks = {};
+    std::pmr::vector<std::uint64_t> m_changed_ticks = {};
+    std::pmr::vector<ObjectPoolRemoval> m_removed = {};
+    std::byte* m_packed = nullptr;
+    std::size_t m_packed_capacity = 0;
+    bool m_packed_adopted = false;
+    std::byte* m_swap_slot = nullptr;
+    ObjectPoolGroup* m_group = nullptr;
+    fnptr_objectpool_type_default_constructor m_type_default_constructor = nullptr;
+    fnptr_objectpool_type_deconstructor m_type_deconstructor = nullptr;
+    fnptr_objectpool_type_relocator m_type_relocator = nullptr;
+    fnptr_objectpool_type_copy_constructor m_type_copy_constructor = nullptr;
+    bool m_type_trivially_copyable = false;
+#ifdef ECS_ENABLE_STATS
+    mutable std::atomic<std::uint64_t> m_lookup_count = 0;
+    mutable std::atomic<std::uint64_t> m_iteration_count = 0;
+#endif
+};
+
+#if defined(__linux__)
+
+/**
+ * @class HugePageResource
+ * @brief Memory resource that maps every allocation of at least ECS_HUGE_PAGE_SIZE bytes
+ * directly with huge pages. When no huge pages are reserved the mapping falls back to normal
+ * pages marked for transparent huge pages. Smaller allocations, such as the index arrays of a
+ * pool, are passed on to the upstream resource
+ *
+ * When numa_node isn't negative the mapped memory is bound to that node. Binding is a best
+ * effort, it's silently skipped if the kernel refuses it
+ */
+class HugePageResource : public std::pmr::memory_resource
+{
+  public:
+    HugePageResource(
+        std::pmr::memory_resource* upstream = std::pmr::get_default_resource(), int numa_node = -1
+    )
+        : m_upstream(upstream), m_numa_node(numa_node)
+    {
+    }
+
+    inline std::pmr::memory_resource* get_upstream() const { return m_upstream; }
+    inline int get_numa_node() const { return m_numa_node; }
+
+  private:
+    static inline std::size_t _mapped_size(std::size_t bytes)
+    {
+        return (bytes + ECS_HUGE_PAGE_SIZE - 1) / ECS_HUGE_PAGE_SIZE * ECS_HUGE_PAGE_SIZE;
+    }
+
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes < ECS_HUGE_PAGE_SIZE || alignment > ECS_HUGE_PAGE_SIZE)
+            return m_upstream->allocate(bytes, alignment);
+
+        const std::size_t size = _mapped_size(bytes);
+        void* data = mmap(
+            nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0
+        );
+
+        if (data == MAP_FAILED)
+        {
+            data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (data == MAP_FAILED)
+                throw std::bad_alloc();
+
+            madvise(data, size, MADV_HUGEPAGE);
+        }
+
+        if (m_numa_node >= 0 && m_numa_node < static_cast<int>(sizeof(unsigned long) * 8))
+        {
+            // MPOL_BIND from <linux/mempolicy.h>, called directly to not depend on libnuma
+            constexpr int mpol_bind = 2;
+            unsigned long mask = 1ul << m_numa_node;
+            syscall(SYS_mbind, data, size, mpol_bind, &mask, sizeof(mask) * 8 + 1, 0);
+        }
+
+        return data;
+    }
+
+    void do_deallocate(void* data, std::size_t bytes, std::size_t alignment) override
+    {
+        if (bytes < ECS_HUGE_PAGE_SIZE || alignment > ECS_HUGE_PAGE_SIZE)
+            m_upstream->deallocate(data, bytes, alignment);
+        else
+            munmap(data, _mapped_size(bytes));
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override
+    {
+        return this == &other;
+    }
+
+  private:
+    std::pmr::memory_resource* m_upstream = nullptr;
+    int m_numa_node = -1;
+};
+
+#endif
+
+/**
+ * @class ObjectPoolMap
+ * @brief Open addressing hash map from ObjectPool::get_type_hash() to the pool. Pools are never
+ * removed from a registry so there is no support for erasing
+ */
+class ObjectPoolMap
+{
+  public:
+    ObjectPoolMap(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_slots(resource)
+    {
+    }
+
+    ObjectPool* find(std::uint64_t hash) const
+    {
+        if (m_slots.empty())
+            return nullptr;
+
+        const std::size_t mask = m_slots.size() - 1;
+        for (std::size_t i = _mix(hash) & mask;; i = (i + 1) & mask)
+        {
+            ObjectPool* pool = m_slots[i];
+            if (pool == nullptr || pool->get_type_hash() == hash)
+                return pool;
+        }
+    }
+
+    void insert(ObjectPool* pool)
+    {
+        if ((m_count + 1) * 2 > m_slots.size())
+            _rehash(m_slots.empty() ? 16 : m_slots.size() * 2);
+
+        _place(pool);
+        m_count++;
+    }
+
+    inline std::size_t size() const { return m_count; }
+
+  private:
+    /**
+     * @brief Final step of splitmix64, this spreads the FNV-1 values over the low bits used to
+     * index the slots
+     */
+    static inline std::size_t _mix(std::uint64_t hash)
+    {
+        hash = (hash ^ (hash >> 30)) * 0xbf58476d1ce4e5b9;
+        hash = (hash ^ (hash >> 27)) * 0x94d049bb133111eb;
+        return static_cast<std::size_t>(hash ^ (hash >> 31));
+    }
+
+    void _place(ObjectPool* pool)
+    {
+        const std::size_t mask = m_slots.size() - 1;
+        std::size_t i = _mix(pool->get_type_hash()) & mask;
+        while (m_slots[i] != nullptr)
+            i = (i + 1) & mask;
+
+        m_slots[i] = pool;
+    }
+
+    void _rehash(std::size_t capacity)
+    {
+        std::pmr::vector<ObjectPool*> slots(capacity, nullptr, m_slots.get_allocator());
+        std::swap(slots, m_slots);
+
+        for (ObjectPool* pool : slots)
+        {
+            if (pool != nullptr)
+                _place(pool);
+        }
+    }
+
+  private:
+    std::pmr::vector<ObjectPool*> m_slots = {};
+    std::size_t m_count = 0;
+};
+
+/**
+ * @class ObjectPoolGroup
+ * @brief Owning group over several pools. The first get_size() dense entries of every owned pool
+ * belong to the same entities in the same order, those entities have every owned component. The
+ * pools call on_insert() and on_remove() to keep that partition
+ */
+class ObjectPoolGroup
+{
+  public:
+    ObjectPoolGroup(
+        std::span<ObjectPool* const> pools,
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource()
+    )
+        : m_pools(pools.begin(), pools.end(), resource)
+    {
+        for (ObjectPool* pool : m_pools)
+        {
+            assert(
+                pool->get_group() == nullptr &&
+                "ECS ASSERT: a pool can only be owned by a single group"
+            );
+            pool->set_group(this);
+        }
+
+        // Every entity in the smallest pool could belong to the group
+        ObjectPool* smallest = *std::min_element(
+            m_pools.begin(), m_pools.end(),
+            [](const ObjectPool* lhs, const ObjectPool* rhs)
+            { return lhs->get_count() < rhs->get_count(); }
+        );
+
+        for (std::size_t i = 0; i < smallest->get_count(); i++)
+            on_insert(smallest->get_dense_entities()[i]);
+    }
+
+    ~ObjectPoolGroup()
+    {
+        for (ObjectPool* pool : m_pools)
+            pool->set_group(nullptr);
+    }
+
+    inline std::size_t get_size() const { return m_size; }
+    inline const std::pmr::vector<ObjectPool*>& get_pools() const { return m_pools; }
+
+    /**
+     * @brief Whether the group owns exactly these pools, in any order
+     */
+    bool owns(std::span<ObjectPool* const> pools) const
+    {
+        return pools.size() == m_pools.size() &&
+               std::all_of(
+                   pools.begin(), pools.end(),
+                   [this](ObjectPool* pool)
+                   { return std::find(m_pools.begin(), m_pools.end(), pool) != m_pools.end(); }
+               );
+    }
+
+    /**
+     * @brief Moves the entity to the end of the group in every pool once it has all of the owned
+     * components
+     */
+    void on_insert(Entity entity)
+    {
+        for (ObjectPool* pool : m_pools)
+        {
+            if (!pool->contains(entity))
+                return;
+        }
+
+        if (m_pools[0]->get_index(entity) < m_size)
+            return;
+
+        for (ObjectPool* pool : m_pools)
+            pool->swap(pool->get_index(entity), m_size);
+
+        m_size++;
+    }
+
+    /**
+     * @brief Moves the entity just past the end of the group in every pool before it loses one of
+     * the owned components
+     */
+    void on_remove(Entity entity)
+    {
+        const std::size_t index = m_pools[0]->get_index(entity);
+        if (index == std::string::npos || index >= m_size)
+            return;
+
+        m_size--;
+        for (ObjectPool* pool : m_pools)
+            pool->swap(pool->get_index(entity), m_size);
+    }
+
+  private:
+    std::pmr::vector<ObjectPool*> m_pools = {};
+    std::size_t m_size = 0;
+};
+
+inline void ObjectPool::_group_insert(Entity entity) { m_group->on_insert(entity); }
+inline void ObjectPool::_group_remove(Entity entity) { m_group->on_remove(entity); }
+
+/**
+ * @class SnapshotHeader
+ * @brief Start of a snapshot written by Registry::serialize(), followed by entity_count entity
+ * ids of the registry and pool_count pools. Every value is stored in the native byte order
+ */
+struct SnapshotHeader
+{
+    std::uint32_t magic = ECS_SNAPSHOT_MAGIC;
+    std::uint32_t version = ECS_SNAPSHOT_VERSION;
+    std::uint64_t entity_count = 0;
+    std::uint32_t free_head = ECS_REGISTRY_FREE_LIST_END;
+    std::uint32_t pool_count = 0;
+};
+
+/**
+ * @class SnapshotPoolHeader
+ * @brief Start of a pool in a snapshot, followed by name_size bytes of the type name, count
+ * entity ids and payload_size bytes holding the objects in dense order. The entity ids are
+ * aligned to 8 bytes and the payload to the pool alignment from the start of the snapshot so a
+ * mapped snapshot can be used in place
+ */
+struct SnapshotPoolHeader
+{
+    std::uint64_t hash = 0;
+    std::uint64_t type_size = 0;
+    std::uint64_t alignment = 0;
+    std::uint64_t block_size = 0;
+    std::uint32_t layout = 0;
+    std::uint32_t name_size = 0;
+    std::uint64_t count = 0;
+    std::uint64_t payload_size = 0;
+};
+
+/**
+ * @class Context
+ * @brief Registry wide resources such as input, time or a physics world. Each type has at most
+ * one instance stored at type_descriptor::get_index<_T>(), so access skips the pool lookup and
+ * the sparse set entirely. See Registry::ctx()
+ */
+class Context
+{
+  public:
+    Context(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_resource(resource), m_resources(resource), m_order(resource)
+    {
+    }
+
+    Context(const Context&) = delete;
+    Context& operator=(const Context&) = delete;
+
+    ~Context()
+    {
+        // Destroyed in reverse so a resource can be constructed from an earlier one
+        for (std::size_t i = m_order.size(); i > 0; i--)
+            _release(m_resources[m_order[i - 1]]);
+    }
+
+    /**
+     * @brief Constructs _T from args unless it exists already, in which case the existing
+     * instance is returned untouched
+     */
+    template<typename _T, typename... _Args>
+    _T& emplace(_Args&&... args)
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        if (index >= m_resources.size())
+            m_resources.resize(index + 1);
+
+        Resource& resource = m_resources[index];
+        if (resource.data == nullptr)
+        {
+            std::byte* data =
+                static_cast<std::byte*>(m_resource->allocate(sizeof(_T), alignof(_T)));
+            new (data) _T(std::forward<_Args>(args)...);
+
+            resource = {data, sizeof(_T), alignof(_T), nullptr};
+            if constexpr (!std::is_trivially_destructible_v<_T>)
+            {
+                resource.deconstructor = [](std::byte* type)
+                { reinterpret_cast<_T*>(type)->~_T(); };
+            }
+
+            m_order.push_back(index);
+        }
+
+        return *reinterpret_cast<_T*>(resource.data);
+    }
+
+    /**
+     * @brief Resource that must have been emplaced, the lookup is a single indexed load
+     */
+    template<typename _T>
+    inline _T& get()
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        assert(
+            index < m_resources.size() && m_resources[index].data != nullptr &&
+            "ECS ASSERT (get()): resource doesn't exist, use emplace() first"
+        );
+        return *reinterpret_cast<_T*>(m_resources[index].data);
+    }
+
+    template<typename _T>
+    inline const _T& get() const
+    {
+        return const_cast<Context*>(this)->get<_T>();
+    }
+
+    /**
+     * @brief Resource or nullptr when it hasn't been emplaced
+     */
+    template<typename _T>
+    inline _T* find()
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        if (index >= m_resources.size())
+            return nullptr;
+
+        return reinterpret_cast<_T*>(m_resources[index].data);
+    }
+
+    template<typename _T>
+    inline const _T* find() const
+    {
+        return const_cast<Context*>(this)->find<_T>();
+    }
+
+    template<typename _T>
+    inline bool contains() const
+    {
+        return find<_T>() != nullptr;
+    }
+
+    /**
+     * @brief Destroys the resource, returns false when it doesn't exist
+     */
+    template<typename _T>
+    bool erase()
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        if (index >= m_resources.size() || m_resources[index].data == nullptr)
+            return false;
+
+        _release(m_resources[index]);
+        m_resources[index] = {};
+        m_order.erase(std::find(m_order.begin(), m_order.end(), index));
+        return true;
+    }
+
+    inline std::size_t get_count() const { return m_order.size(); }
+
+  private:
+    struct Resource
+    {
+        std::byte* data = nullptr;
+        std::size_t size = 0;
+        std::size_t alignment = 0;
+        fnptr_objectpool_type_deconstructor deconstructor = nullptr;
+    };
+
+    void _release(Resource& resource)
+    {
+        if (resource.deconstructor != nullptr)
+            resource.deconstructor(resource.data);
+
+        m_resource->deallocate(resource.data, resource.size, resource.alignment);
+    }
+
+  private:
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+    std::pmr::vector<Resource> m_resources = {};
+    std::pmr::vector<std::size_t> m_order = {};
+};
+
+/**
+ * @class Relationship
+ * @brief Hierarchy links of an entity, managed through Registry::set_parent(). Missing links
+ * are ECS_ENTITY_DESTROYED. Once Registry::sort_hierarchy() has run the pool is in depth first
+ * order, so every parent comes before its children and the subtree of the entity at dense index
+ * i covers [i, i + 1 + descendant_count)
+ */
+struct Relationship
+{
+    Entity parent = ECS_ENTITY_DESTROYED;
+    Entity first_child = ECS_ENTITY_DESTROYED;
+    Entity next_sibling = ECS_ENTITY_DESTROYED;
+    Entity prev_sibling = ECS_ENTITY_DESTROYED;
+    std::uint32_t child_count = 0;
+    std::uint32_t descendant_count = 0;
+};
+
+/**
+ * @class DeltaHeader
+ * @brief Start of a replication delta written by DeltaEncoder, followed by pool_count pools. tick
+ * is the registry tick the delta ended and since the tick of the baseline it's relative to, both
+ * are for the application to match deltas with acknowledgements
+ */
+struct DeltaHeader
+{
+    std::uint32_t magic = ECS_DELTA_MAGIC;
+    std::uint32_t version = ECS_DELTA_VERSION;
+    std::uint64_t tick = 0;
+    std::uint64_t since = 0;
+    std::uint32_t pool_count = 0;
+    std::uint32_t padding = 0;
+};
+
+/**
+ * @class DeltaPoolHeader
+ * @brief Start of a pool in a delta, followed by name_size bytes of the type name, removed_count
+ * entities whose object was removed, count entities and count objects XORed with the baseline.
+ * Every part is padded to 8 bytes so the entity ids can be read in place
+ */
+struct DeltaPoolHeader
+{
+    std::uint64_t hash = 0;
+    std::uint64_t type_size = 0;
+    std::uint64_t alignment = 0;
+    std::uint32_t name_size = 0;
+    std::uint32_t padding = 0;
+    std::uint64_t removed_count = 0;
+    std::uint64_t count = 0;
+};
+
+class CommandBuffer;
+class ReplicationBaseline;
+
+template<typename _T, typename... _Ts>
+class Group;
+
+/**
+ * @class RegistryStats
+ * @brief Sum of the ObjectPoolStats of every pool in a registry along with its entity counts.
+ * fragmentation is weighted by how many chunks each pool has touched
+ */
+struct RegistryStats
+{
+    std::size_t entity_count = 0;
+    std::size_t free_entity_count = 0;
+    std::size_t pool_count = 0;
+    ObjectPoolStats pools = {};
+};
+
+class Registry
+{
+  public:
+    /**
+     * @brief Every pool, its blocks and index arrays are allocated from the memory resource. Give
+     * each level its own std::pmr::monotonic_buffer_resource to release everything at once
+     */
+    Registry(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_resource(resource), m_pools(resource), m_typed_pools(resource), m_pool_map(resource),
+          m_groups(resource), m_context(resource)
+    {
+    }
+
+    ~Registry()
+    {
+        for (ObjectPoolGroup* group : m_groups)
+            std::pmr::polymorphic_allocator<ObjectPoolGroup>(m_resource).delete_object(group);
+
+        for (ObjectPool* pool : m_pools)
+            ObjectPool::destroy(pool);
+
+#if defined(__linux__)
+        for (const Mapping& mapping : m_mappings)
+            munmap(mapping.data, mapping.size);
+#endif
+    }
+
+    inline std::pmr::memory_resource* get_resource() const { return m_resource; }
+
+    /**
+     * @brief Singleton resources of the registry, see Context
+     */
+    inline Context& ctx() { return m_context; }
+    inline const Context& ctx() const { return m_context; }
+
+    /**
+     * @brief Reuses the most recently destroyed index with its bumped generation before growing
+     * m_entities
+     */
+    Entity create_entity()
+    {
+        if (m_free_head != ECS_REGISTRY_FREE_LIST_END)
+        {
+            const std::uint32_t index = m_free_head;
+            m_free_head = m_entities[index].get_index();
+
+            m_entities[index] = Entity::create(index, m_entities[index].get_generation());
+            return m_entities[index];
+        }
+
+        m_entities.push_back(Entity::create(static_cast<std::uint32_t>(m_entities.size()), 0));
+        return m_entities.back();
+    }
+
+    /**
+     * @brief Creates out.size() entities, reusing destroyed entities first
+     */
+    void create_entities(std::span<Entity> out)
+    {
+        std::size_t i = 0;
+        for (; i < out.size() && m_free_head != ECS_REGISTRY_FREE_LIST_END; i++)
+            out[i] = create_entity();
+
+        m_entities.reserve(m_entities.size() + out.size() - i);
+        for (; i < out.size(); i++)
+        {
+            m_entities.push_back(Entity::create(static_cast<std::uint32_t>(m_entities.size()), 0));
+            out[i] = m_entities.back();
+        }
+    }
+
+    /**
+     * @brief Whether the entity is alive, destroyed slots of m_entities hold the next index of
+     * the free list so they never compare equal to a handle for that slot
+     */
+    inline bool valid(Entity entity) const
+    {
+        return entity.get_index() < m_entities.size() && m_entities[entity.get_index()] == entity;
+    }
+
+    inline void create_entities(std::size_t count, Entity* out)
+    {
+        create_entities(std::span<Entity>(out, count));
+    }
+
+    /**
+     * @brief Walks the entity free list and every pool, meant for occasional reporting rather
+     * than for every frame
+     */
+    RegistryStats get_stats() const
+    {
+        RegistryStats stats = {};
+        for (std::uint32_t index = m_free_head; index != ECS_REGISTRY_FREE_LIST_END;
+             index = m_entities[index].get_index())
+            stats.free_entity_count++;
+
+        stats.entity_count = m_entities.size() - stats.free_entity_count;
+        stats.pool_count = m_pools.size();
+
+        std::size_t touched = 0;
+        std::size_t freed = 0;
+        for (const ObjectPool* pool : m_pools)
+        {
+            ObjectPoolStats pool_stats = pool->get_stats();
+            stats.pools.count += pool_stats.count;
+            stats.pools.capacity += pool_stats.capacity;
+            stats.pools.free_count += pool_stats.free_count;
+            stats.pools.block_count += pool_stats.block_count;
+            stats.pools.reserved_bytes += pool_stats.reserved_bytes;
+            stats.pools.used_bytes += pool_stats.used_bytes;
+            stats.pools.lookups += pool_stats.lookups;
+            stats.pools.iterations += pool_stats.iterations;
+
+            if (pool->get_layout() == ObjectPoolLayout::Chunked)
+            {
+                touched += pool_stats.count + pool_stats.free_count;
+                freed += pool_stats.free_count;
+            }
+        }
+
+        if (touched > 0)
+            stats.pools.fragmentation = static_cast<double>(freed) / touched;
+
+        return stats;
+    }
+
+    inline void reset_stats()
+    {
+        for (ObjectPool* pool : m_pools)
+            pool->reset_stats();
+    }
+
+    /**
+     * @brief Compacts every pool, see ObjectPool::compact(). Component pointers are invalid
+     * afterwards
+     */
+    void compact()
+    {
+        for (ObjectPool* pool : m_pools)
+            pool->compact();
+
+        m_hierarchy_sorted = false;
+    }
+
+    /**
+     * @brief Incrementally compacts the pools in order until budget has passed, call it once a
+     * frame until it returns true. See ObjectPool::compact(budget)
+     */
+    bool compact(std::chrono::nanoseconds budget)
+    {
+        m_hierarchy_sorted = false;
+        const auto deadline = std::chrono::steady_clock::now() + budget;
+        for (ObjectPool* pool : m_pools)
+        {
+            const auto now = std::chrono::steady_clock::now();
+            if (now >= deadline || !pool->compact(deadline - now))
+                return false;
+        }
+
+        return true;
+    }
+
+    inline std::vector<Entity>& get_entities() { return m_entities; }
+    inline std::pmr::vector<ObjectPool*>& get_pools() { return m_pools; }
+    inline const std::vector<Entity>& get_entities() const { return m_entities; }
+    inline const std::pmr::vector<ObjectPool*>& get_pools() const { return m_pools; }
+
+    /**
+     * @brief Typed lookups index directly by type_descriptor::get_index<_T>(). A pool added by
+     * hash, e.g. through create_component(), merge() or load(), is found by its hash the first
+     * time and cached, unless the typed pools are locked, see lock_typed_pools()
+     */
+    template<typename _T>
+    inline ObjectPool* get_pool()
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        if (index < m_typed_pools.size() && m_typed_pools[index] != nullptr)
+            return m_typed_pools[index];
+
+        ObjectPool* pool = get_pool(type_descriptor::get_hash<_T>());
+        if (pool != nullptr && m_typed_pools_locks == 0)
+            _index_typed_pool(index, pool);
+
+        return pool;
+    }
+
+    template<typename _T>
+    inline const ObjectPool* get_pool() const
+    {
+        return const_cast<Registry*>(this)->get_pool<_T>();
+    }
+
+    inline const ObjectPool* get_pool(std::uint64_t hash) const { return m_pool_map.find(hash); }
+    inline ObjectPool* get_pool(std::uint64_t hash) { return m_pool_map.find(hash); }
+
+    /**
+     * @brief Stops typed lookups from caching pools so get_pool<_T>() only reads the registry and
+     * can be called from several threads at once. Scheduler::run() holds the lock through
+     * TypedPoolsLock while systems run. The lock isn't thread safe itself, locking and unlocking
+     * only happen on the thread that starts the concurrent work, never inside of it
+     */
+    inline void lock_typed_pools()
+    {
+        assert(
+            (m_typed_pools_locks == 0 || m_typed_pools_owner == std::this_thread::get_id()) &&
+            "ECS ASSERT (lock_typed_pools()): typed pools are locked by another thread"
+        );
+
+        m_typed_pools_owner = std::this_thread::get_id();
+        m_typed_pools_locks++;
+    }
+
+    inline void unlock_typed_pools()
+    {
+        assert(
+            m_typed_pools_locks > 0 && m_typed_pools_owner == std::this_thread::get_id() &&
+            "ECS ASSERT (unlock_typed_pools()): typed pools aren't locked by this thread"
+        );
+
+        m_typed_pools_locks--;
+    }
+
+    inline bool is_typed_pools_locked() const { return m_typed_pools_locks > 0; }
+
+    /**
+     * @class TypedPoolsLock
+     * @brief Holds lock_typed_pools() until it goes out of scope, including by an exception
+     */
+    class TypedPoolsLock
+    {
+      public:
+        TypedPoolsLock(Registry& registry) : m_registry(registry) { registry.lock_typed_pools(); }
+        ~TypedPoolsLock() { m_registry.unlock_typed_pools(); }
+
+        TypedPoolsLock(const TypedPoolsLock&) = delete;
+        TypedPoolsLock& operator=(const TypedPoolsLock&) = delete;
+
+      private:
+        Registry& m_registry;
+    };
+
+    /**
+     * @brief Creates the pool used to store _T with the given layout. It has to be called before
+     * the first _T is created otherwise the existing pool is returned unchanged
+     *
+     * Passing ECS_SIMD_ALIGNMENT as the alignment makes a packed array start on a cache line and
+     * be padded to a whole number of vectors, see ObjectPool::get_padded_count()
+     */
+    template<typename _T>
+    ObjectPool* create_pool(
+        ObjectPoolLayout layout, std::size_t block_size = ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE,
+        std::size_t alignment = alignof(_T)
+    )
+    {
+        ObjectPool* target = get_pool<_T>();
+        if (target == nullptr)
+        {
+            target = ObjectPool::create<_T>(block_size, layout, m_resource, alignment);
+            _add_pool(target);
+            _index_typed_pool(type_descriptor::get_index<_T>(), target);
+        }
+
+        return target;
+    }
+
+    /**
+     * @brief Sorts the components of _T with compare(const _T& lhs, const _T& rhs), relocating
+     * them so views over _T read them in order. See ObjectPool::sort()
+     */
+    template<typename _T, typename _Compare>
+    void sort(_Compare compare, SortAlgorithm algorithm = SortAlgorithm::Standard)
+    {
+        ObjectPool* pool = get_pool<_T>();
+        if (pool == nullptr)
+            return;
+
+        pool->sort(
+            [pool, &compare](std::size_t lhs, std::size_t rhs)
+            {
+                return compare(
+                    *reinterpret_cast<const _T*>(pool->get_object(lhs)),
+                    *reinterpret_cast<const _T*>(pool->get_object(rhs))
+                );
+            },
+            algorithm
+        );
+    }
+
+    /**
+     * @brief Sorts the components of _T in the entity order of _By's pool so views over both
+     * walk the two pools in lockstep. See ObjectPool::sort_as()
+     */
+    template<typename _T, typename _By>
+    void sort()
+    {
+        ObjectPool* pool = get_pool<_T>();
+        const ObjectPool* by = get_pool<_By>();
+        if (pool != nullptr && by != nullptr)
+            pool->sort_as(*by);
+    }
+
+    /**
+     * @brief Moves every entity of other into this registry with new ids and leaves other
+     * empty. Pools the registry doesn't have yet are created like the ones of other, see
+     * ObjectPool::merge() for when blocks are spliced instead of relocated. Relationship links
+     * are remapped, other entity references held by components have to be remapped by the
+     * caller. Groups and the Context of other are not merged
+     *
+     * @return std::vector<Entity> New entity for each index of other, ECS_ENTITY_DESTROYED for
+     * indices that weren't alive
+     */
+    std::vector<Entity> merge(Registry&& other)
+    {
+        assert(&other != this && "ECS ASSERT (merge()): cannot merge a registry into itself");
+
+        std::vector<Entity> alive = {};
+        for (Entity entity : other.m_entities)
+        {
+            if (other.valid(entity))
+                alive.push_back(entity);
+        }
+
+        std::vector<Entity> created = std::vector<Entity>(alive.size());
+        create_entities(created);
+        std::vector<Entity> remap =
+            std::vector<Entity>(other.m_entities.size(), ECS_ENTITY_DESTROYED);
+        for (std::size_t i = 0; i < alive.size(); i++)
+            remap[alive[i].get_index()] = created[i];
+
+        for (ObjectPool* source : other.m_pools)
+        {
+            ObjectPool* target = get_pool(source->get_type_hash());
+            if (target == nullptr)
+            {
+                target = ObjectPool::create_like(*source, m_resource);
+                _add_pool(target);
+            }
+
+            target->merge(*source, remap);
+        }
+
+        for (Entity entity : created)
+        {
+            Relationship* link = get_component<Relationship>(entity);
+            if (link == nullptr)
+                continue;
+
+            for (Entity* handle :
+                 {&link->parent, &link->first_child, &link->next_sibling, &link->prev_sibling})
+            {
+                if (*handle != ECS_ENTITY_DESTROYED)
+                    *handle = remap[handle->get_index()];
+            }
+            m_hierarchy_sorted = false;
+        }
+
+        other.m_entities.clear();
+        other.m_free_head = ECS_REGISTRY_FREE_LIST_END;
+        return remap;
+    }
+
+    /**
+     * @brief Makes child the first child of parent, detaching it from its previous parent. Pass
+     * ECS_ENTITY_DESTROYED as the parent to make child a root. Both get a Relationship if they
+     * don't have one yet, the hierarchy is sorted again by the next propagate()
+     */
+    void set_parent(Entity child, Entity parent)
+    {
+        assert(valid(child) && "ECS ASSERT (set_parent()): child is not alive");
+        assert(
+            (parent == ECS_ENTITY_DESTROYED || valid(parent)) &&
+            "ECS ASSERT (set_parent()): parent is not alive"
+        );
+        assert(
+            (parent == ECS_ENTITY_DESTROYED || !_is_descendant(parent, child)) &&
+            "ECS ASSERT (set_parent()): parent is a descendant of child"
+        );
+
+        // Create both before taking pointers, growing a packed pool moves its objects
+        if (get_component<Relationship>(child) == nullptr)
+            create_component<Relationship>(child);
+        if (parent != ECS_ENTITY_DESTROYED && get_component<Relationship>(parent) == nullptr)
+            create_component<Relationship>(parent);
+
+        _detach(child);
+        if (parent != ECS_ENTITY_DESTROYED)
+        {
+            Relationship* link = get_component<Relationship>(child);
+            Relationship* owner = get_component<Relationship>(parent);
+            link->parent = parent;
+            link->next_sibling = owner->first_child;
+            if (owner->first_child != ECS_ENTITY_DESTROYED)
+                get_component<Relationship>(owner->first_child)->prev_sibling = child;
+
+            owner->first_child = child;
+            owner->child_count++;
+        }
+
+        m_hierarchy_sorted = false;
+    }
+
+    /**
+     * @brief Parent of the entity or ECS_ENTITY_DESTROYED when it's a root or has no Relationship
+     */
+    Entity get_parent(Entity entity)
+    {
+        const Relationship* link = get_component<Relationship>(entity);
+        return link != nullptr ? link->parent : ECS_ENTITY_DESTROYED;
+    }
+
+    /**
+     * @brief Sorts the Relationship pool into depth first order, roots keep their relative order
+     * and children follow their first_child/next_sibling links. The pools of _Ts are sorted to
+     * match so a sweep over the hierarchy reads them sequentially, see ObjectPool::sort_as()
+     */
+    template<typename... _Ts>
+    void sort_hierarchy()
+    {
+        ObjectPool* pool = get_pool<Relationship>();
+        if (pool == nullptr)
+            return;
+
+        const std::size_t count = pool->get_count();
+        std::pmr::vector<Entity> order = std::pmr::vector<Entity>(m_resource);
+        std::pmr::vector<Entity> stack = std::pmr::vector<Entity>(m_resource);
+        order.reserve(count);
+        for (std::size_t i = 0; i < count; i++)
+        {
+            Relationship* root = reinterpret_cast<Relationship*>(pool->get_object(i));
+            if (root->parent != ECS_ENTITY_DESTROYED)
+                continue;
+
+            stack.push_back(pool->get_dense_entities()[i]);
+            while (!stack.empty())
+            {
+                const Entity entity = stack.back();
+                stack.pop_back();
+                order.push_back(entity);
+
+                // Pushed in reverse so the first child is visited first
+                const std::size_t top = stack.size();
+                const Relationship* link = pool->get_entitys_object<Relationship>(entity);
+                for (Entity child = link->first_child; child != ECS_ENTITY_DESTROYED;
+                     child = pool->get_entitys_object<Relationship>(child)->next_sibling)
+                    stack.push_back(child);
+                std::reverse(stack.begin() + top, stack.end());
+            }
+        }
+
+        pool->sort_as(order);
+
+        // Children come after their parent so a reverse sweep sums every subtree
+        for (std::size_t i = 0; i < count; i++)
+            reinterpret_cast<Relationship*>(pool->get_object(i))->descendant_count = 0;
+        for (std::size_t i = count; i > 0; i--)
+        {
+            const Relationship* link = reinterpret_cast<Relationship*>(pool->get_object(i - 1));
+            if (link->parent != ECS_ENTITY_DESTROYED)
+            {
+                pool->get_entitys_object<Relationship>(link->parent)->descendant_count +=
+                    link->descendant_count + 1;
+            }
+        }
+
+        (sort<_Ts, Relationship>(), ...);
+        m_hierarchy_sorted = true;
+    }
+
+    /**
+     * @brief Calls fn(const _T* parent, _T& child) for every entity in the hierarchy that has a
+     * _T, parents always before their children. parent is nullptr for roots and for entities
+     * whose parent has no _T. Sorts the hierarchy first if it has changed and the _T pool to
+     * match it, which is a single pass when the _T pool already does
+     */
+    template<typename _T, typename _Fn>
+    void propagate(_Fn fn)
+    {
+        ECS_PROFILE_SCOPE("ecs::Registry::propagate");
+        ObjectPool* pool = nullptr;
+        ObjectPool* target = nullptr;
+        if (_prepare_propagation<_T>(pool, target))
+            _propagate<_T>(pool, target, 0, pool->get_count(), fn);
+    }
+
+    /**
+     * @brief propagate() with whole root subtrees split into batches of at least grain_size
+     * entities that are run on the global ThreadPool. fn is called concurrently for different
+     * subtrees
+     */
+    template<typename _T, typename _Fn>
+    void par_propagate(_Fn fn, std::size_t grain_size = ECS_VIEW_DEFAULT_GRAIN_SIZE);
+
+    /**
+     * @brief par_propagate() using the given executor, see View::par_each()
+     */
+    template<typename _T, typename _Fn, typename _Executor>
+    void par_propagate(
+        _Fn fn, _Executor& executor, std::size_t grain_size = ECS_VIEW_DEFAULT_GRAIN_SIZE
+    )
+    {
+        assert(grain_size > 0 && "ECS ASSERT: grain_size must be larger than 0");
+        ECS_PROFILE_SCOPE("ecs::Registry::par_propagate");
+        ObjectPool* pool = nullptr;
+        ObjectPool* target = nullptr;
+        if (!_prepare_propagation<_T>(pool, target))
+            return;
+
+        // Every batch starts on a root and ends after the last entity of a subtree
+        std::vector<std::pair<std::size_t, std::size_t>> batches = {};
+        const std::size_t count = pool->get_count();
+        for (std::size_t index = 0; index < count;)
+        {
+            const std::size_t first = index;
+            while (index < count && index - first < grain_size)
+            {
+                Relationship* root = reinterpret_cast<Relationship*>(pool->get_object(index));
+                index += root->descendant_count + 1;
+            }
+
+            batches.emplace_back(first, index);
+        }
+
+        executor.run(
+            batches.size(),
+            [this, &batches, &fn, pool, target](std::size_t batch)
+            {
+                ECS_PROFILE_SCOPE("ecs::Registry::par_propagate batch");
+                _propagate<_T>(pool, target, batches[batch].first, batches[batch].second, fn);
+            }
+        );
+    }
+
+    /**
+     * @brief Owning group over the pools of _T and _Ts, the pools are created if needed. The
+     * first time the pools are grouped they're reordered so every entity with all of the
+     * components comes first in the same order in each pool, and every create and destroy keeps
+     * it that way. Calling it again returns a group over the same partition
+     *
+     * A pool can only be owned by one group. Create the pools as packed beforehand to get
+     * contiguous arrays from Group::data()
+     */
+    template<typename _T, typename... _Ts>
+    Group<_T, _Ts...> group()
+    {
+        const std::array<ObjectPool*, 1 + sizeof...(_Ts)> pools = {
+            create_pool<std::remove_cv_t<_T>>(ObjectPoolLayout::Chunked),
+            create_pool<std::remove_cv_t<_Ts>>(ObjectPoolLayout::Chunked)...,
+        };
+
+        ObjectPoolGroup* owner = pools[0]->get_group();
+        if (owner == nullptr)
+        {
+            owner = std::pmr::polymorphic_allocator<ObjectPoolGroup>(m_resource)
+                        .new_object<ObjectPoolGroup>(pools, m_resource);
+            m_groups.push_back(owner);
+        }
+
+        assert(
+            owner->owns(pools) &&
+            "ECS ASSERT (group()): one of the pools is already owned by another group"
+        );
+        return Group<_T, _Ts...>(owner, pools);
+    }
+
+    template<typename _T>
+    _T* get_component(Entity entity)
+    {
+        ObjectPool* pool = get_pool<_T>();
+        if (pool != nullptr)
+            return pool->get_entitys_object<_T>(entity);
+
+        return nullptr;
+    }
+
+    void* get_component(Entity entity, std::uint64_t hash)
+    {
+        ObjectPool* pool = get_pool(hash);
+        if (pool != nullptr)
+            return reinterpret_cast<void*>(pool->get_entitys_object(entity));
+
+        return nullptr;
+    }
+
+    const void* get_component(Entity entity, std::uint64_t hash) const
+    {
+        return const_cast<Registry*>(this)->get_component(entity, hash);
+    }
+
+    void destroy_entity(Entity entity)
+    {
+        assert(
+            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (destroy_entity(entity)): entity "
+                                              "provided id is set to ECS_Entity_DESTRSOYED"
+        );
+        assert(
+            valid(entity) && "ECS ASSERT (destroy_entity(entity)): entity provided is not alive"
+        );
+
+        _unlink_hierarchy(entity);
+        for (ObjectPool* pool : m_pools)
+            pool->free(entity);
+
+        std::uint32_t generation = entity.get_generation() + 1;
+        if (generation > ECS_ENTITY_MAX_GENERATION)
+            generation = 0;
+
+        const std::uint32_t index = entity.get_index();
+        m_entities[index] = Entity::create(m_free_head, generation);
+        m_free_head = index;
+    }
+
+    template<typename _T, typename... _Args>
+    _T* create_component(Entity entity, _Args&&... args)
+    {
+        assert(
+            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (create_component(entity, ...)): cannot "
+                                              "create component onto destroyed entity"
+        );
+
+        ObjectPool* target = get_pool<_T>();
+        if (target == nullptr)
+            target = create_pool<_T>(ObjectPoolLayout::Chunked);
+
+        return target->malloc<_T>(entity, std::forward<_Args>(args)...);
+    }
+
+    /**
+     * @brief Creates a copy of prototype for every entity, the pool is looked up and grown once
+     * for all of them
+     */
+    template<typename _T>
+    void create_components(std::span<const Entity> entities, const _T& prototype)
+    {
+        ObjectPool* target = get_pool<_T>();
+        if (target == nullptr)
+            target = create_pool<_T>(ObjectPoolLayout::Chunked);
+
+        target->malloc<_T>(entities, prototype);
+    }
+
+    /**
+     * @brief Creates out.size() entities that each get a copy of every component of prefab. Each
+     * pool is reserved once and copies all of the components in one pass, with std::memcpy for
+     * trivially copyable components. The Relationship isn't copied as its links belong to the
+     * prefab, the copies are roots until set_parent() is called for them
+     */
+    void instantiate(Entity prefab, std::span<Entity> out)
+    {
+        instantiate(*this, prefab, out);
+    }
+
+    /**
+     * @brief Same as above except prefab belongs to another registry, such as one that only holds
+     * prefabs so they're never seen by views of this registry. Missing pools are created like the
+     * prefab's pools
+     */
+    void instantiate(const Registry& prefabs, Entity prefab, std::span<Entity> out)
+    {
+        assert(
+            prefabs.valid(prefab) &&
+            "ECS ASSERT (instantiate(prefabs, prefab, out)): prefab is not alive"
+        );
+
+        create_entities(out);
+        for (std::size_t i = 0; i < prefabs.m_pools.size(); i++)
+        {
+            ObjectPool* source = prefabs.m_pools[i];
+            const std::byte* prototype = source->get_entitys_object(prefab);
+            if (prototype == nullptr ||
+                source->get_type_hash() == type_descriptor::get_hash<Relationship>())
+                continue;
+
+            ObjectPool* target = get_pool(source->get_type_hash());
+            if (target == nullptr)
+            {
+                target = ObjectPool::create_like(*source, m_resource);
+                _add_pool(target);
+            }
+
+            target->copy(out, prototype);
+        }
+    }
+
+    inline std::vector<Entity> instantiate(Entity prefab, std::size_t count)
+    {
+        std::vector<Entity> entities = std::vector<Entity>(count);
+        instantiate(prefab, entities);
+        return entities;
+    }
+
+    /**
+     * @brief Preallocates storage for count objects of _T, creating the pool if needed
+     */
+    template<typename _T>
+    ObjectPool* reserve(std::size_t count)
+    {
+        ObjectPool* target = get_pool<_T>();
+        if (target == nullptr)
+            target = create_pool<_T>(ObjectPoolLayout::Chunked);
+
+        target->reserve(count);
+        return target;
+    }
+
+    /**
+     * @brief Turns on change tracking for _T, creating its pool if needed. See
+     * ObjectPool::set_change_tracking() and the Changed and Added view filters
+     */
+    template<typename _T>
+    ObjectPool* track()
+    {
+        ObjectPool* target = get_pool<_T>();
+        if (target == nullptr)
+            target = create_pool<_T>(ObjectPoolLayout::Chunked);
+
+        if (!target->is_tracking_changes())
+            target->set_change_tracking(&m_tick);
+
+        return target;
+    }
+
+    /**
+     * @brief Component of the entity for writing, stamped as changed at the current tick so
+     * Changed<_T> views see it. Writes through get_component() aren't tracked
+     */
+    template<typename _T>
+    _T* patch(Entity entity)
+    {
+        ObjectPool* pool = get_pool<_T>();
+        if (pool == nullptr || !pool->mark_changed(entity))
+            return nullptr;
+
+        return pool->get_entitys_object<_T>(entity);
+    }
+
+    inline std::uint64_t get_tick() const { return m_tick.load(std::memory_order_relaxed); }
+
+    /**
+     * @brief Ends the current tick and returns it, every change made after this call has a
+     * larger tick. A system that wants the changes since its last run advances the tick before
+     * reading and keeps the returned tick for its next run:
+     *
+     *     const std::uint64_t since = last_run;
+     *     last_run = registry.advance_tick();
+     *     View<Transform, Changed<Transform>>(&registry, since).each(...);
+     *
+     * Changes made at the same time as the view runs may be seen by both this and the next run,
+     * but no change is ever missed
+     */
+    inline std::uint64_t advance_tick() { return m_tick.fetch_add(1, std::memory_order_relaxed); }
+
+    template<typename _T>
+    inline bool destroy_component(Entity entity)
+    {
+        ObjectPool* pool = get_pool<_T>();
+        return pool != nullptr && _free_component(pool, entity);
+    }
+
+    inline bool destroy_component(Entity entity, std::uint64_t hash)
+    {
+        ObjectPool* pool = get_pool(hash);
+        return pool != nullptr && _free_component(pool, entity);
+    }
+
+    /**
+     * @brief Writes the entities and every pool of trivially copyable components as raw bytes,
+     * see SnapshotHeader. Pools of other components are skipped as they can't be restored from
+     * their bytes
+     */
+    void serialize(std::ostream& stream) const
+    {
+        std::size_t offset = 0;
+        auto write = [&stream, &offset](const void* data, std::size_t size)
+        {
+            stream.write(static_cast<const char*>(data), static_cast<std::streamsize>(size));
+            offset += size;
+        };
+        auto pad = [&stream, &offset](std::size_t alignment)
+        {
+            for (; offset % alignment != 0; offset++)
+                stream.put(0);
+        };
+
+        SnapshotHeader header = {};
+        header.entity_count = m_entities.size();
+        header.free_head = m_free_head;
+        for (const ObjectPool* pool : m_pools)
+            header.pool_count += pool->is_trivially_copyable();
+
+        write(&header, sizeof(SnapshotHeader));
+        write(m_entities.data(), sizeof(Entity) * m_entities.size());
+
+        for (ObjectPool* pool : m_pools)
+        {
+            if (!pool->is_trivially_copyable())
+                continue;
+
+            const bool packed = pool->get_layout() == ObjectPoolLayout::Packed;
+            SnapshotPoolHeader pool_header = {};
+            pool_header.hash = pool->get_type_hash();
+            pool_header.type_size = pool->get_type_size();
+            pool_header.alignment = pool->get_type_alignment();
+            pool_header.block_size = pool->get_block_size();
+            pool_header.layout = static_cast<std::uint32_t>(pool->get_layout());
+            pool_header.name_size = static_cast<std::uint32_t>(pool->get_name().size());
+            pool_header.count = pool->get_count();
+            pool_header.payload_size =
+                pool->get_type_size() * (packed ? pool->get_padded_count() : pool->get_count());
+
+            write(&pool_header, sizeof(SnapshotPoolHeader));
+            write(pool->get_name().data(), pool_header.name_size);
+            pad(alignof(Entity));
+            write(pool->get_dense_entities().data(), sizeof(Entity) * pool_header.count);
+            pad(std::max<std::size_t>(pool_header.alignment, alignof(Entity)));
+
+            if (packed)
+            {
+                write(pool->data(), pool_header.type_size * pool_header.count);
+                for (std::size_t i = pool_header.count; i < pool->get_padded_count(); i++)
+                {
+                    for (std::size_t j = 0; j < pool_header.type_size; j++)
+                        stream.put(0);
+                    offset += pool_header.type_size;
+                }
+            }
+            else
+            {
+                for (std::size_t i = 0; i < pool_header.count; i++)
+                    write(pool->get_object(i), pool_header.type_size);
+            }
+        }
+    }
+
+    /**
+     * @brief Loads a snapshot written by serialize() into a registry without entities. Pools
+     * that already exist, such as ones created with create_pool(), are filled in and keep
+     * their layout, the others are created as runtime typed pools
+     *
+     * @return false if the stream isn't a snapshot of this version, ends early or holds counts,
+     * alignments or layouts no pool could have, the registry is left partially loaded in that
+     * case
+     */
+    bool deserialize(std::istream& stream)
+    {
+        StreamReader reader = StreamReader{stream};
+        reader.size = StreamReader::get_remaining(stream);
+        return _load_snapshot(reader, nullptr);
+    }
+
+#if defined(__linux__)
+    /**
+     * @brief Same as deserialize() except the snapshot file is mapped copy on write. Packed pools
+     * of the snapshot adopt their payload in the mapping as their storage without copying it,
+     * other pools copy from the mapping. The mapping is kept until the registry is destroyed
+     */
+    bool load_mapped(const std::string& path)
+    {
+        const int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return false;
+
+        struct stat status = {};
+        void* data = MAP_FAILED;
+        if (fstat(file, &status) == 0 && status.st_size > 0)
+        {
+            data = mmap(
+                nullptr, static_cast<std::size_t>(status.st_size), PROT_READ | PROT_WRITE,
+                MAP_PRIVATE, file, 0
+            );
+        }
+
+        close(file);
+        if (data == MAP_FAILED)
+            return false;
+
+        const Mapping mapping = Mapping{data, static_cast<std::size_t>(status.st_size)};
+        MemoryReader reader = MemoryReader{static_cast<std::byte*>(data), mapping.size};
+
+        std::size_t adopted = 0;
+        const bool loaded = _load_snapshot(reader, &adopted);
+        if (adopted > 0)
+            m_mappings.push_back(mapping);
+        else
+            munmap(mapping.data, mapping.size);
+
+        return loaded;
+    }
+#endif
+
+    /**
+     * @brief Applies and then clears every command recorded in the buffer
+     */
+    void flush(CommandBuffer& buffer);
+
+    std::byte* create_component(
+        Entity entity, std::uint64_t id, const std::string& name, std::size_t size,
+        fnptr_objectpool_type_deconstructor deconstructor,
+        fnptr_objectpool_type_default_constructor default_constsructor,
+        std::size_t block_size = ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE,
+        ObjectPoolLayout layout = ObjectPoolLayout::Chunked,
+        std::size_t alignment = alignof(std::max_align_t)
+    )
+    {
+        assert(
+            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (create_component(entity, ...)): cannot "
+                                              "create component onto destroyed entity"
+        );
+
+        ObjectPool* target = get_pool(id);
+        if (target == nullptr)
+        {
+            target =
+                ObjectPool::create(name, size, id, block_size, layout, m_resource, alignment);
+            target->set_deconstructor(deconstructor);
+            target->set_default_constructor(default_constsructor);
+            _add_pool(target);
+        }
+
+        return target->malloc(entity);
+    }
+
+    /**
+     * @brief Applies a delta written by DeltaEncoder straight from its bytes, every object is
+     * the baseline's object XORed with the delta so the baseline has to be the one the delta was
+     * encoded against. Without a baseline the objects of this registry are the baseline, which
+     * is how ReplicationBaseline moves itself forward
+     *
+     * Objects are written into the pools directly with the entity ids of the sender, the
+     * receiving registry is meant to mirror the sender rather than create its own entities. Pools
+     * that don't exist are created as runtime typed pools
+     *
+     * @return false if the bytes aren't a delta of this version or a pool doesn't match, the
+     * registry is left partially updated in that case
+     */
+    bool apply_delta(
+        std::span<const std::byte> delta, const ReplicationBaseline* baseline = nullptr
+    );
+
+  private:
+    /**
+     * @brief Reads a snapshot from a stream through a buffer that is reused for every read
+     */
+    struct StreamReader
+    {
+        std::istream& stream;
+        std::vector<std::byte> buffer = {};
+        std::size_t offset = 0;
+        std::size_t size = std::numeric_limits<std::size_t>::max();
+
+        static constexpr bool mapped = false;
+
+        /**
+         * @brief Bytes left in the stream, the largest size if the stream can't seek
+         */
+        static std::size_t get_remaining(std::istream& stream)
+        {
+            const std::streampos position = stream.tellg();
+            if (position == std::streampos(-1) || !stream.seekg(0, std::ios::end))
+            {
+                stream.clear();
+                return std::numeric_limits<std::size_t>::max();
+            }
+
+            const std::streampos end = stream.tellg();
+            stream.seekg(position);
+            return static_cast<std::size_t>(end - position);
+        }
+
+        const std::byte* read(std::size_t count)
+        {
+            if (count > size - offset)
+                return nullptr;
+
+            buffer.resize(std::max<std::size_t>(count, 1));
+            stream.read(
+                reinterpret_cast<char*>(buffer.data()), static_cast<std::streamsize>(count)
+            );
+            if (static_cast<std::size_t>(stream.gcount()) != count)
+                return nullptr;
+
+            offset += count;
+            return buffer.data();
+        }
+
+        /**
+         * @brief See MemoryReader::read(count, element_size)
+         */
+        const std::byte* read(std::size_t count, std::size_t element_size)
+        {
+            if (element_size != 0 && count > (size - offset) / element_size)
+                return nullptr;
+
+            return read(count * element_size);
+        }
+
+        bool align(std::size_t alignment)
+        {
+            const std::size_t padding = (alignment - offset % alignment) % alignment;
+            return padding == 0 || read(padding) != nullptr;
+        }
+    };
+
+    /**
+     * @brief Reads a snapshot in place from memory, reads return pointers into the memory
+     */
+    struct MemoryReader
+    {
+        std::byte* data = nullptr;
+        std::size_t size = 0;
+        std::size_t offset = 0;
+
+        static constexpr bool mapped = true;
+
+        std::byte* read(std::size_t count)
+        {
+            if (count > size - offset)
+                return nullptr;
+
+            offset += count;
+            return data + offset - count;
+        }
+
+        /**
+         * @brief Reads count elements of element_size bytes, the count is checked against what
+         * is left before multiplying so a corrupt count can't wrap around
+         */
+        std::byte* read(std::size_t count, std::size_t element_size)
+        {
+            if (element_size != 0 && count > (size - offset) / element_size)
+                return nullptr;
+
+            return read(count * element_size);
+        }
+
+        bool align(std::size_t alignment)
+        {
+            const std::size_t padding = (alignment - offset % alignment) % alignment;
+            return read(padding) != nullptr;
+        }
+    };
+
+    /**
+     * @brief Whether an alignment read from a snapshot or a delta can be given to ObjectPool
+     */
+    static bool _valid_alignment(std::uint64_t alignment)
+    {
+        return alignment > 0 && (alignment & (alignment - 1)) == 0;
+    }
+
+    /**
+     * @brief Counts the pools that adopted memory of the reader in adopted, only readers over
+     * memory that outlives the registry can be adopted from
+     */
+    template<typename _Reader>
+    bool _load_snapshot(_Reader& reader, std::size_t* adopted)
+    {
+        assert(
+            m_entities.empty() &&
+            "ECS ASSERT (deserialize(stream)): snapshots can only be loaded into a registry "
+            "without entities"
+        );
+
+        SnapshotHeader header = {};
+        const std::byte* bytes = reader.read(sizeof(SnapshotHeader));
+        if (bytes == nullptr)
+            return false;
+
+        std::memcpy(&header, bytes, sizeof(SnapshotHeader));
+        if (header.magic != ECS_SNAPSHOT_MAGIC || header.version != ECS_SNAPSHOT_VERSION)
+            return false;
+
+        bytes = reader.read(header.entity_count, sizeof(Entity));
+        if (bytes == nullptr || (header.free_head != ECS_REGISTRY_FREE_LIST_END &&
+                                 header.free_head >= header.entity_count))
+            return false;
+
+        m_entities.resize(header.entity_count);
+        std::memcpy(m_entities.data(), bytes, sizeof(Entity) * header.entity_count);
+        m_free_head = header.free_head;
+
+        std::pmr::vector<Entity> entities = std::pmr::vector<Entity>(m_resource);
+        for (std::uint32_t i = 0; i < header.pool_count; i++)
+        {
+            SnapshotPoolHeader pool_header = {};
+            bytes = reader.read(sizeof(SnapshotPoolHeader));
+            if (bytes == nullptr)
+                return false;
+
+            std::memcpy(&pool_header, bytes, sizeof(SnapshotPoolHeader));
+            bytes = reader.read(pool_header.name_size);
+            if (bytes == nullptr || pool_header.type_size == 0 || pool_header.name_size == 0 ||
+                pool_header.block_size == 0 || !_valid_alignment(pool_header.alignment) ||
+                pool_header.layout > static_cast<std::uint32_t>(ObjectPoolLayout::Packed))
+                return false;
+
+            const std::string name =
+                std::string(reinterpret_cast<const char*>(bytes), pool_header.name_size);
+            if (!reader.align(alignof(Entity)))
+                return false;
+
+            bytes = reader.read(pool_header.count, sizeof(Entity));
+            if (bytes == nullptr)
+                return false;
+
+            entities.resize(pool_header.count);
+            std::memcpy(entities.data(), bytes, sizeof(Entity) * pool_header.count);
+            for (Entity entity : entities)
+            {
+                if (!valid(entity))
+                    return false;
+            }
+
+            ObjectPool* pool = get_pool(pool_header.hash);
+            if (pool == nullptr)
+            {
+                pool = ObjectPool::create(
+                    name, pool_header.type_size, pool_header.hash, pool_header.block_size,
+                    static_cast<ObjectPoolLayout>(pool_header.layout), m_resource,
+                    pool_header.alignment
+                );
+                pool->set_trivially_copyable(true);
+                _add_pool(pool);
+            }
+            else if (pool->get_type_size() != pool_header.type_size ||
+                     !pool->is_trivially_copyable() || pool->get_count() > 0)
+                return false;
+
+            if (!reader.align(std::max<std::size_t>(pool_header.alignment, alignof(Entity))))
+                return false;
+
+            const std::size_t capacity = pool_header.payload_size / pool_header.type_size;
+            std::byte* payload = const_cast<std::byte*>(reader.read(pool_header.payload_size));
+            if (payload == nullptr || capacity < pool_header.count)
+                return false;
+
+            if constexpr (_Reader::mapped)
+            {
+                if (pool_header.count > 0 && pool->adopt(entities, payload, capacity))
+                {
+                    (*adopted)++;
+                    continue;
+                }
+            }
+
+            pool->load(entities, payload);
+        }
+
+        return true;
+    }
+
+    inline void _add_pool(ObjectPool* pool)
+    {
+        m_pools.push_back(pool);
+        m_pool_map.insert(pool);
+    }
+
+    /**
+     * @brief Sorts the hierarchy if it has changed and the _T pool to match it, unless the pool
+     * is owned by a group. Every propagated type is matched separately as its pool may have
+     * changed order since the hierarchy was sorted
+     */
+    template<typename _T>
+    bool _prepare_propagation(ObjectPool*& pool, ObjectPool*& target)
+    {
+        if (!m_hierarchy_sorted)
+            sort_hierarchy();
+
+        pool = get_pool<Relationship>();
+        target = get_pool<_T>();
+        if (pool == nullptr || target == nullptr)
+            return false;
+
+        if (target != pool && target->get_group() == nullptr)
+            target->sort_as(*pool);
+
+        return true;
+    }
+
+    /**
+     * @brief Sweeps the dense range [first, last) of the sorted Relationship pool
+     */
+    template<typename _T, typename _Fn>
+    void _propagate(
+        ObjectPool* pool, ObjectPool* target, std::size_t first, std::size_t last, _Fn& fn
+    )
+    {
+        for (std::size_t i = first; i < last; i++)
+        {
+            _T* child = target->get_entitys_object<_T>(pool->get_dense_entities()[i]);
+            if (child == nullptr)
+                continue;
+
+            const Relationship* link = reinterpret_cast<Relationship*>(pool->get_object(i));
+            const _T* parent = link->parent != ECS_ENTITY_DESTROYED
+                                   ? target->get_entitys_object<_T>(link->parent)
+                                   : nullptr;
+            fn(parent, *child);
+        }
+    }
+
+    bool _is_descendant(Entity entity, Entity ancestor)
+    {
+        for (Entity current = entity; current != ECS_ENTITY_DESTROYED;
+             current = get_parent(current))
+        {
+            if (current == ancestor)
+                return true;
+        }
+
+        return false;
+    }
+
+    /**
+     * @brief Removes the entity from its parent's children, leaving its own children untouched
+     */
+    void _detach(Entity entity)
+    {
+        Relationship* link = get_component<Relationship>(entity);
+        if (link == nullptr || link->parent == ECS_ENTITY_DESTROYED)
+            return;
+
+        Relationship* owner = get_component<Relationship>(link->parent);
+        if (link->prev_sibling != ECS_ENTITY_DESTROYED)
+            get_component<Relationship>(link->prev_sibling)->next_sibling = link->next_sibling;
+        else
+            owner->first_child = link->next_sibling;
+
+        if (link->next_sibling != ECS_ENTITY_DESTROYED)
+            get_component<Relationship>(link->next_sibling)->prev_sibling = link->prev_sibling;
+
+        owner->child_count--;
+        link->parent = ECS_ENTITY_DESTROYED;
+        link->next_sibling = ECS_ENTITY_DESTROYED;
+        link->prev_sibling = ECS_ENTITY_DESTROYED;
+    }
+
+    /**
+     * @brief Frees the object of the entity, a Relationship is unlinked from the hierarchy first
+     * so no link is left pointing at it
+     */
+    bool _free_component(ObjectPool* pool, Entity entity)
+    {
+        if (pool->get_type_hash() == type_descriptor::get_hash<Relationship>())
+            _unlink_hierarchy(entity);
+
+        return pool->free(entity);
+    }
+
+    /**
+     * @brief Detaches an entity that loses its Relationship from the hierarchy, its children
+     * become roots
+     */
+    void _unlink_hierarchy(Entity entity)
+    {
+        Relationship* link = get_component<Relationship>(entity);
+        if (link == nullptr)
+            return;
+
+        _detach(entity);
+        for (Entity child = link->first_child; child != ECS_ENTITY_DESTROYED;)
+        {
+            Relationship* child_link = get_component<Relationship>(child);
+            child = child_link->next_sibling;
+            child_link->parent = ECS_ENTITY_DESTROYED;
+            child_link->next_sibling = ECS_ENTITY_DESTROYED;
+            child_link->prev_sibling = ECS_ENTITY_DESTROYED;
+        }
+
+        m_hierarchy_sorted = false;
+    }
+
+    inline void _index_typed_pool(std::size_t index, ObjectPool* pool)
+    {
+        if (index >= m_typed_pools.size())
+            m_typed_pools.resize(index + 1, nullptr);
+
+        m_typed_pools[index] = pool;
+    }
+
+  private:
+    std::pmr::memory_resource* m_resource = std::pmr::get_default_resource();
+    std::vector<Entity> m_entities = {};
+    std::uint32_t m_free_head = ECS_REGISTRY_FREE_LIST_END;
+    std::pmr::vector<ObjectPool*> m_pools = {};
+    std::pmr::vector<ObjectPool*> m_typed_pools = {};
+    std::size_t m_typed_pools_locks = 0;
+    std::thread::id m_typed_pools_owner = {};
+    ObjectPoolMap m_pool_map = {};
+    std::pmr::vector<ObjectPoolGroup*> m_groups = {};
+    std::atomic<std::uint64_t> m_tick = 1;
+    Context m_context = {};
+    bool m_hierarchy_sorted = false;
+
+#if defined(__linux__)
+    struct Mapping
+    {
+        void* data = nullptr;
+        std::size_t size = 0;
+    };
+
+    std::vector<Mapping> m_mappings = {};
+#endif
+};
+
+/**
+ * @enum CommandType
+ * @brief Structural change recorded by a CommandBuffer
+ */
+enum class CommandType
+{
+    CreateComponent,
+    DestroyComponent,
+    DestroyEntity,
+};
+
+/**
+ * @class Command
+ * @brief Single change recorded by a CommandBuffer. Create component commands own a fully
+ * constructed component in the buffer's arena that is moved into the pool on flush
+ */
+struct Command
+{
+    CommandType type = CommandType::DestroyEntity;
+    Entity entity = {};
+    std::uint64_t hash = 0;
+    std::byte* payload = nullptr;
+    ObjectPool* (*create_pool)(Registry& registry) = nullptr;
+    void (*emplace)(ObjectPool* pool, Entity entity, std::byte* payload) = nullptr;
+    fnptr_objectpool_type_deconstructor deconstructor = nullptr;
+};
+
+/**
+ * @class CommandBuffer
+ * @brief Records creating and destroying entities and components so they can be applied later
+ * with Registry::flush(), for example after iterating over a View. A buffer isn't thread safe,
+ * use one buffer per thread and flush them one after another
+ *
+ * Entities returned by create_entity() are placeholders that are only meaningful to commands in
+ * the same buffer until it's flushed
+ */
+class CommandBuffer
+{
+  public:
+    /**
+     * @brief Generation the placeholder entities are created with, placeholders use their index
+     * as the position in the buffer
+     */
+    static constexpr std::uint32_t placeholder_generation = ECS_ENTITY_MAX_GENERATION + 1;
+
+  public:
+    CommandBuffer(std::size_t arena_block_size = ECS_COMMAND_BUFFER_ARENA_BLOCK_SIZE)
+        : m_arena_block_size(arena_block_size)
+    {
+    }
+
+    CommandBuffer(const CommandBuffer&) = delete;
+    CommandBuffer& operator=(const CommandBuffer&) = delete;
+
+    ~CommandBuffer()
+    {
+        clear();
+        for (ArenaBlock& block : m_arena)
+            std::free(block.data);
+    }
+
+    inline Entity create_entity()
+    {
+        return Entity::create(static_cast<std::uint32_t>(m_created_count++), placeholder_generation);
+    }
+
+    inline static bool is_placeholder(Entity entity)
+    {
+        return entity.get_generation() == placeholder_generation;
+    }
+
+    template<typename _T, typename... _Args>
+    void create_component(Entity entity, _Args&&... args)
+    {
+        std::byte* payload = _arena_allocate(sizeof(_T), alignof(_T));
+        new (reinterpret_cast<_T*>(payload)) _T(std::forward<_Args>(args)...);
+
+        Command command = {};
+        command.type = CommandType::CreateComponent;
+        command.entity = entity;
+        command.hash = type_descriptor::get_hash<_T>();
+        command.payload = payload;
+        command.create_pool = [](Registry& registry) -> ObjectPool*
+        { return registry.create_pool<_T>(ObjectPoolLayout::Chunked); };
+        command.emplace = [](ObjectPool* pool, Entity entity, std::byte* payload)
+        {
+            _T* source = reinterpret_cast<_T*>(payload);
+            pool->malloc<_T>(entity, std::move(*source));
+            source->~_T();
+        };
+        command.deconstructor = [](std::byte* payload) { reinterpret_cast<_T*>(payload)->~_T(); };
+        m_commands.push_back(command);
+    }
+
+    template<typename _T>
+    inline void destroy_component(Entity entity)
+    {
+        destroy_component(entity, type_descriptor::get_hash<_T>());
+    }
+
+    inline void destroy_component(Entity entity, std::uint64_t hash)
+    {
+        Command command = {};
+        command.type = CommandType::DestroyComponent;
+        command.entity = entity;
+        command.hash = hash;
+        m_commands.push_back(command);
+    }
+
+    inline void destroy_entity(Entity entity)
+    {
+        Command command = {};
+        command.type = CommandType::DestroyEntity;
+        command.entity = entity;
+        m_commands.push_back(command);
+    }
+
+    inline bool empty() const { return m_commands.empty() && m_created_count == 0; }
+    inline std::size_t get_created_count() const { return m_created_count; }
+    inline std::vector<Command>& get_commands() { return m_commands; }
+    inline const std::vector<Command>& get_commands() const { return m_commands; }
+
+    /**
+     * @brief Drops every recorded command, destroying components that were never flushed. The
+     * arena blocks are kept to be reused by the next commands
+     */
+    void clear()
+    {
+        for (Command& command : m_commands)
+        {
+            if (command.payload != nullptr && command.deconstructor != nullptr)
+                command.deconstructor(command.payload);
+        }
+
+        m_commands.clear();
+        m_created_count = 0;
+        m_arena_block = 0;
+        for (ArenaBlock& block : m_arena)
+            block.used = 0;
+    }
+
+  private:
+    struct ArenaBlock
+    {
+        std::byte* data = nullptr;
+        std::size_t size = 0;
+        std::size_t used = 0;
+    };
+
+  private:
+    std::byte* _arena_allocate(std::size_t size, std::size_t alignment)
+    {
+        for (; m_arena_block < m_arena.size(); m_arena_block++)
+        {
+            ArenaBlock& block = m_arena[m_arena_block];
+            std::size_t offset = (block.used + alignment - 1) / alignment * alignment;
+            if (offset + size <= block.size)
+            {
+                block.used = offset + size;
+                return block.data + offset;
+            }
+        }
+
+        // std::malloc is at least aligned to alignof(std::max_align_t) which is the largest an
+        // offset of 0 needs unless the type is over aligned
+        ArenaBlock block = {};
+        block.size = std::max(m_arena_block_size, size + alignment);
+        block.data = static_cast<std::byte*>(std::malloc(block.size));
+        m_arena.push_back(block);
+
+        ArenaBlock& back = m_arena.back();
+        std::size_t offset =
+            (alignment - reinterpret_cast<std::uintptr_t>(back.data) % alignment) % alignment;
+        back.used = offset + size;
+        return back.data + offset;
+    }
+
+  private:
+    const std::size_t m_arena_block_size = 0;
+    std::vector<Command> m_commands = {};
+    std::vector<ArenaBlock> m_arena = {};
+    std::size_t m_arena_block = 0;
+    std::size_t m_created_count = 0;
+};
+
+/**
+ * @brief Entities are created first, then component creation and destruction are applied grouped
+ * by pool in the order they were recorded, destroying entities comes last. Creating a component
+ * the entity already owns replaces it
+ */
+inline void Registry::flush(CommandBuffer& buffer)
+{
+    std::vector<Entity> created = std::vector<Entity>(buffer.get_created_count());
+    create_entities(created);
+
+    std::vector<Command>& commands = buffer.get_commands();
+    for (Command& command : commands)
+    {
+        if (CommandBuffer::is_placeholder(command.entity))
+            command.entity = created[command.entity.get_index()];
+    }
+
+    std::vector<Command*> sorted = {};
+    sorted.reserve(commands.size());
+    for (Command& command : commands)
+    {
+        if (command.type != CommandType::DestroyEntity)
+            sorted.push_back(&command);
+    }
+
+    std::stable_sort(
+        sorted.begin(), sorted.end(),
+        [](const Command* lhs, const Command* rhs) { return lhs->hash < rhs->hash; }
+    );
+
+    ObjectPool* pool = nullptr;
+    for (Command* command : sorted)
+    {
+        if (pool == nullptr || pool->get_type_hash() != command->hash)
+        {
+            pool = get_pool(command->hash);
+            if (pool == nullptr && command->create_pool != nullptr)
+                pool = command->create_pool(*this);
+        }
+
+        if (pool == nullptr)
+            continue;
+
+        if (command->type == CommandType::CreateComponent)
+        {
+            _free_component(pool, command->entity);
+            command->emplace(pool, command->entity, command->payload);
+            command->payload = nullptr;
+        }
+        else
+            _free_component(pool, command->entity);
+    }
+
+    for (Command& command : commands)
+    {
+        if (command.type == CommandType::DestroyEntity)
+            destroy_entity(command.entity);
+    }
+
+    buffer.clear();
+}
+
+/**
+ * @class ReplicationBaseline
+ * @brief Objects a receiver is known to have, usually the state of the last delta it
+ * acknowledged. The sender and the receiver each keep one and move it forward with the same
+ * acknowledged deltas, so both agree on what the next delta is relative to. See DeltaEncoder
+ */
+class ReplicationBaseline
+{
+  public:
+    ReplicationBaseline(std::pmr::memory_resource* resource = std::pmr::get_default_resource())
+        : m_state(resource)
+    {
+    }
+
+    /**
+     * @brief Baseline object of the entity for the pool with the hash, nullptr when the receiver
+     * doesn't have one
+     */
+    const std::byte* find(std::uint64_t hash, Entity entity) const
+    {
+        ObjectPool* pool = const_cast<Registry&>(m_state).get_pool(hash);
+        return pool != nullptr ? pool->get_entitys_object(entity) : nullptr;
+    }
+
+    /**
+     * @brief Moves the baseline forward by a delta that was encoded against it, call it once
+     * the receiver acknowledged the delta
+     */
+    bool apply(std::span<const std::byte> delta)
+    {
+        if (!m_state.apply_delta(delta))
+            return false;
+
+        DeltaHeader header = {};
+        std::memcpy(&header, delta.data(), sizeof(DeltaHeader));
+        m_tick = header.tick;
+        return true;
+    }
+
+    /**
+     * @brief Tick of the last applied delta, every change stamped after it is missing
+     */
+    inline std::uint64_t get_tick() const { return m_tick; }
+    inline const Registry& get_state() const { return m_state; }
+
+  private:
+    Registry m_state;
+    std::uint64_t m_tick = 0;
+};
+
+inline bool Registry::apply_delta(
+    std::span<const std::byte> delta, const ReplicationBaseline* baseline
+)
+{
+    MemoryReader reader = MemoryReader{const_cast<std::byte*>(delta.data()), delta.size()};
+    DeltaHeader header = {};
+    const std::byte* bytes = reader.read(sizeof(DeltaHeader));
+    if (bytes == nullptr)
+        return false;
+
+    std::memcpy(&header, bytes, sizeof(DeltaHeader));
+    if (header.magic != ECS_DELTA_MAGIC || header.version != ECS_DELTA_VERSION)
+        return false;
+
+    for (std::uint32_t i = 0; i < header.pool_count; i++)
+    {
+        DeltaPoolHeader pool_header = {};
+        bytes = reader.read(sizeof(DeltaPoolHeader));
+        if (bytes == nullptr)
+            return false;
+
+        std::memcpy(&pool_header, bytes, sizeof(DeltaPoolHeader));
+        const std::byte* name = reader.read(pool_header.name_size);
+        if (name == nullptr || pool_header.name_size == 0 || pool_header.type_size == 0 ||
+            !_valid_alignment(pool_header.alignment) || !reader.align(alignof(Entity)))
+            return false;
+
+        const Entity* removed = reinterpret_cast<const Entity*>(
+            reader.read(pool_header.removed_count, sizeof(Entity))
+        );
+        const Entity* entities =
+            reinterpret_cast<const Entity*>(reader.read(pool_header.count, sizeof(Entity)));
+        const std::byte* payload = reader.read(pool_header.count, pool_header.type_size);
+        if (removed == nullptr || entities == nullptr || payload == nullptr ||
+            !reader.align(alignof(Entity)))
+            return false;
+
+        ObjectPool* pool = get_pool(pool_header.hash);
+        if (pool == nullptr)
+        {
+            pool = ObjectPool::create(
+                std::string(reinterpret_cast<const char*>(name), pool_header.name_size),
+                pool_header.type_size, pool_header.hash, ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE,
+                ObjectPoolLayout::Chunked, m_resource, pool_header.alignment
+            );
+            pool->set_trivially_copyable(true);
+            _add_pool(pool);
+        }
+        else if (pool->get_type_size() != pool_header.type_size || !pool->is_trivially_copyable())
+            return false;
+
+        // Removals first, the index may have been reused by an entity of a newer generation
+        for (std::size_t j = 0; j < pool_header.removed_count; j++)
+            pool->free(removed[j]);
+
+        const std::size_t size = pool_header.type_size;
+        for (std::size_t j = 0; j < pool_header.count; j++)
+        {
+            const Entity entity = entities[j];
+            const std::byte* change = payload + size * j;
+            const std::byte* base = baseline != nullptr
+                                        ? baseline->find(pool_header.hash, entity)
+                                        : pool->get_entitys_object(entity);
+
+            std::byte* object = pool->get_entitys_object(entity);
+            if (object == nullptr)
+            {
+                pool->load(std::span<const Entity>(&entity, 1), change);
+                if (base == nullptr)
+                    continue;
+
+                object = pool->get_entitys_object(entity);
+            }
+            else
+                pool->mark_changed(entity);
+
+            if (base != nullptr)
+            {
+                for (std::size_t k = 0; k < size; k++)
+                    object[k] = base[k] ^ change[k];
+            }
+            else
+                std::memcpy(object, change, size);
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @class ConcurrentRegistry
+ * @brief Opt-in thread safe access to a Registry for code that runs outside the Scheduler. The
+ * registry itself is left untouched, so code using it directly keeps the single threaded path
+ *
+ * Readers and writers of different pools don't block each other, each pool has its own shared
+ * mutex and a registry wide one is only taken exclusively to create pools, grow the entity
+ * array or destroy entities. create_entity() hands out entities created up front with a single
+ * atomic increment and only locks once all entity_capacity of them are used. Pools owned by a
+ * group are written under the exclusive lock since the group touches all of its pools
+ *
+ * The registry must not be used directly while the wrapper is, component pointers aren't
+ * handed out as they could move as soon as the pool lock is released
+ */
+class ConcurrentRegistry
+{
+  public:
+    ConcurrentRegistry(Registry& registry, std::size_t entity_capacity = 1024)
+        : m_registry(registry), m_reserved(entity_capacity)
+    {
+        registry.create_entities(m_reserved);
+    }
+
+    ConcurrentRegistry(const ConcurrentRegistry&) = delete;
+    ConcurrentRegistry& operator=(const ConcurrentRegistry&) = delete;
+
+    /**
+     * @brief Destroys the reserved entities that were never handed out
+     */
+    ~ConcurrentRegistry()
+    {
+        const std::size_t used = std::min(m_cursor.load(), m_reserved.size());
+        for (std::size_t i = used; i < m_reserved.size(); i++)
+            m_registry.destroy_entity(m_reserved[i]);
+    }
+
+    inline Registry& get_registry() { return m_registry; }
+
+    Entity create_entity()
+    {
+        const std::size_t index = m_cursor.fetch_add(1, std::memory_order_relaxed);
+        if (index < m_reserved.size())
+            return m_reserved[index];
+
+        std::unique_lock lock = std::unique_lock(m_mutex);
+        return m_registry.create_entity();
+    }
+
+    void destroy_entity(Entity entity)
+    {
+        std::unique_lock lock = std::unique_lock(m_mutex);
+        m_registry.destroy_entity(entity);
+    }
+
+    bool valid(Entity entity)
+    {
+        std::shared_lock lock = std::shared_lock(m_mutex);
+        return m_registry.valid(entity);
+    }
+
+    template<typename _T, typename... _Args>
+    void create_component(Entity entity, _Args&&... args)
+    {
+        {
+            std::shared_lock lock = std::shared_lock(m_mutex);
+            PoolLock* pool = _lock<_T>(lock, true);
+            if (pool->pool->get_group() == nullptr)
+            {
+                std::unique_lock pool_lock = std::unique_lock(pool->mutex);
+                m_registry.create_component<_T>(entity, std::forward<_Args>(args)...);
+                return;
+            }
+        }
+
+        std::unique_lock lock = std::unique_lock(m_mutex);
+        m_registry.create_component<_T>(entity, std::forward<_Args>(args)...);
+    }
+
+    template<typename _T>
+    bool destroy_component(Entity entity)
+    {
+        {
+            std::shared_lock lock = std::shared_lock(m_mutex);
+            PoolLock* pool = _lock<_T>(lock, false);
+            if (pool == nullptr)
+                return false;
+
+            if (pool->pool->get_group() == nullptr)
+            {
+                std::unique_lock pool_lock = std::unique_lock(pool->mutex);
+                return m_registry.destroy_component<_T>(entity);
+            }
+        }
+
+        std::unique_lock lock = std::unique_lock(m_mutex);
+        return m_registry.destroy_component<_T>(entity);
+    }
+
+    /**
+     * @brief Calls fn(const _T&) with the component under a shared lock of its pool
+     *
+     * @return false when the entity doesn't have a _T
+     */
+    template<typename _T, typename _Fn>
+    bool read(Entity entity, _Fn fn)
+    {
+        std::shared_lock lock = std::shared_lock(m_mutex);
+        PoolLock* pool = _lock<_T>(lock, false);
+        if (pool == nullptr)
+            return false;
+
+        std::shared_lock pool_lock = std::shared_lock(pool->mutex);
+        const _T* component = pool->pool->get_entitys_object<_T>(entity);
+        if (component == nullptr)
+            return false;
+
+        fn(*component);
+        return true;
+    }
+
+    /**
+     * @brief Calls fn(_T&) with the component under an exclusive lock of its pool, the component
+     * is marked as changed when the pool tracks changes. See Registry::patch()
+     *
+     * @return false when the entity doesn't have a _T
+     */
+    template<typename _T, typename _Fn>
+    bool write(Entity entity, _Fn fn)
+    {
+        std::shared_lock lock = std::shared_lock(m_mutex);
+        PoolLock* pool = _lock<_T>(lock, false);
+        if (pool == nullptr)
+            return false;
+
+        std::unique_lock pool_lock = std::unique_lock(pool->mutex);
+        _T* component = m_registry.patch<_T>(entity);
+        if (component == nullptr)
+            return false;
+
+        fn(*component);
+        return true;
+    }
+
+  private:
+    struct PoolLock
+    {
+        std::shared_mutex mutex = {};
+        ObjectPool* pool = nullptr;
+    };
+
+    /**
+     * @brief Lock of the pool of _T with m_mutex held shared through lock. The first access of a
+     * type briefly takes m_mutex exclusively to register the pool, creating it when create is
+     * set, and returns nullptr if there is no pool
+     */
+    template<typename _T>
+    PoolLock* _lock(std::shared_lock<std::shared_mutex>& lock, bool create)
+    {
+        const std::size_t index = type_descriptor::get_index<_T>();
+        if (index < m_pools.size() && m_pools[index].pool != nullptr)
+            return &m_pools[index];
+
+        lock.unlock();
+        PoolLock* pool = _register<_T>(create);
+        lock.lock();
+        return pool;
+    }
+
+    /**
+     * @brief Takes m_mutex exclusively, which also lets the registry cache its typed pool lookup
+     * so later shared accesses of the registry only read
+     */
+    template<typename _T>
+    PoolLock* _register(bool create)
+    {
+        std::unique_lock lock = std::unique_lock(m_mutex);
+        const std::size_t index = type_descriptor::get_index<_T>();
+        while (m_pools.size() <= index)
+            m_pools.emplace_back();
+
+        PoolLock& pool = m_pools[index];
+        if (pool.pool == nullptr)
+        {
+            pool.pool = m_registry.get_pool<_T>();
+            if (pool.pool == nullptr && create)
+                pool.pool = m_registry.create_pool<_T>(ObjectPoolLayout::Chunked);
+        }
+
+        return pool.pool != nullptr ? &pool : nullptr;
+    }
+
+  private:
+    Registry& m_registry;
+    std::vector<Entity> m_reserved = {};
+    std::atomic<std::size_t> m_cursor = 0;
+    std::shared_mutex m_mutex = {};
+    std::deque<PoolLock> m_pools = {};
+};
+
+/**
+ * @class ThreadPool
+ * @brief Work stealing thread pool used to run batches of a parallel loop. Every worker owns a
+ * queue that it pops from the front of and, once it runs dry, steals from the back of the other
+ * workers queues. The thread calling run() works on the batches as well until all of them are
+ * done, so run() may be called from inside a job without dead locking
+ *
+ * Any other type with a matching run(count, job) member function can be given to
+ * View::par_each() in its place to use an external executor
+ */
+class ThreadPool
+{
+  public:
+    /**
+     * @brief Pool shared by everything that doesn't provide its own, it's created on first use
+     * with one worker less than the hardware threads as the calling thread helps out
+     */
+    static ThreadPool& get_global()
+    {
+        static ThreadPool pool = ThreadPool(
+            std::thread::hardware_concurrency() > 1 ? std::thread::hardware_concurrency() - 1 : 0
+        );
+        return pool;
+    }
+
+  public:
+    ThreadPool(std::size_t thread_count) : m_queues(thread_count)
+    {
+        m_threads.reserve(thread_count);
+        for (std::size_t i = 0; i < thread_count; i++)
+            m_threads.emplace_back([this, i]() { _worker(i); });
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    ~ThreadPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+            m_stop = true;
+        }
+
+        m_sleep.notify_all();
+        for (std::thread& thread : m_threads)
+            thread.join();
+    }
+
+    inline std::size_t get_thread_count() const { return m_threads.size(); }
+
+    /**
+     * @brief Calls job(index) for every index in [0, count) across the workers and the calling
+     * thread, returning once all of them have finished
+     */
+    void run(std::size_t count, const std::function<void(std::size_t)>& job)
+    {
+        if (m_queues.empty() || count < 2)
+        {
+            for (std::size_t i = 0; i < count; i++)
+                job(i);
+            return;
+        }
+
+        std::atomic<std::size_t> remaining = count;
+        m_pending.fetch_add(count, std::memory_order_release);
+
+        // Hand every worker a contiguous run of batches so neighbouring batches stay together
+        // until they are stolen
+        const std::size_t per_queue = (count + m_queues.size() - 1) / m_queues.size();
+        for (std::size_t q = 0; q < m_queues.size(); q++)
+        {
+            std::lock_guard<std::mutex> lock(m_queues[q].mutex);
+            for (std::size_t i = q * per_queue; i < count && i < (q + 1) * per_queue; i++)
+                m_queues[q].jobs.push_back(Job{&job, i, &remaining});
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_sleep_mutex);
+        }
+        m_sleep.notify_all();
+
+        while (remaining.load(std::memory_order_acquire) > 0)
+        {
+            Job current = {};
+            if (_steal(0, current))
+                _execute(current);
+            else
+                std::this_thread::yield();
+        }
+    }
+
+  private:
+    struct Job
+    {
+        const std::function<void(std::size_t)>* job = nullptr;
+        std::size_t index = 0;
+        std::atomic<std::size_t>* remaining = nullptr;
+    };
+
+    struct Queue
+    {
+        std::mutex mutex = {};
+        std::deque<Job> jobs = {};
+    };
+
+  private:
+    inline void _execute(const Job& current)
+    {
+        (*current.job)(current.index);
+        current.remaining->fetch_sub(1, std::memory_order_acq_rel);
+    }
+
+    bool _pop(std::size_t queue, Job& out)
+    {
+        std::lock_guard<std::mutex> lock(m_queues[queue].mutex);
+        if (m_queues[queue].jobs.empty())
+            return false;
+
+        out = m_queues[queue].jobs.front();
+        m_queues[queue].jobs.pop_front();
+        m_pending.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    /**
+     * @brief Takes a job from the back of any queue, starting with the one after the given queue
+     */
+    bool _steal(std::size_t start, Job& out)
+    {
+        for (std::size_t i = 0; i < m_queues.size(); i++)
+        {
+            Queue& queue = m_queues[(start + i) % m_queues.size()];
+
+            std::lock_guard<std::mutex> lock(queue.mutex);
+            if (!queue.jobs.empty())
+            {
+                out = queue.jobs.back();
+                queue.jobs.pop_back();
+                m_pending.fetch_sub(1, std::memory_order_relaxed);
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    void _worker(std::size_t index)
+    {
+        for (;;)
+        {
+            Job current = {};
+            if (_pop(index, current) || _steal(index + 1, current))
+            {
+                _execute(current);
+                continue;
+            }
+
+            std::unique_lock<std::mutex> lock(m_sleep_mutex);
+            m_sleep.wait(
+                lock, [this]() { return m_stop || m_pending.load(std::memory_order_acquire) > 0; }
+            );
+
+            if (m_stop)
+                return;
+        }
+    }
+
+  private:
+    std::vector<Queue> m_queues = {};
+    std::vector<std::thread> m_threads = {};
+    std::atomic<std::size_t> m_pending = 0;
+    std::mutex m_sleep_mutex = {};
+    std::condition_variable m_sleep = {};
+    bool m_stop = false;
+};
+
+/**
+ * @class DeltaEncoder
+ * @brief Writes the components that changed since a ReplicationBaseline as a delta, see
+ * DeltaHeader. Each object is XORed with its baseline so unchanged bytes encode as zeros that
+ * compress well, objects equal to the baseline are left out and removed objects are listed.
+ * Only trivially copyable pools with change tracking are replicated, see Registry::track(), and
+ * removals must not be cleared past the baseline tick, see ObjectPool::clear_removed()
+ *
+ * Pools are encoded in parallel into buffers that are kept between calls. Encoding ends the
+ * registry's tick with Registry::advance_tick() like the change tracking views do, so writes made
+ * after encode() returns have a larger tick and are sent by the next delta
+ *
+ * A delta always holds every change since the baseline, so deltas that were sent but not yet
+ * acknowledged can be dropped by the transport. Once the receiver acknowledges one, both sides
+ * apply it to their baseline with ReplicationBaseline::apply()
+ */
+class DeltaEncoder
+{
+  public:
+    void encode(
+        Registry& registry, const ReplicationBaseline& baseline, std::vector<std::byte>& out
+    )
+    {
+        encode(registry, baseline, out, ThreadPool::get_global());
+    }
+
+    /**
+     * @brief encode() using the given executor, see View::par_each()
+     */
+    template<typename _Executor>
+    void encode(
+        Registry& registry, const ReplicationBaseline& baseline, std::vector<std::byte>& out,
+        _Executor& executor
+    )
+    {
+        ECS_PROFILE_SCOPE("ecs::DeltaEncoder::encode");
+        m_pools.clear();
+        for (ObjectPool* pool : registry.get_pools())
+        {
+            if (pool->is_trivially_copyable() && pool->is_tracking_changes())
+                m_pools.push_back(pool);
+        }
+
+        if (m_sections.size() < m_pools.size())
+            m_sections.resize(m_pools.size());
+
+        const std::uint64_t since = baseline.get_tick();
+        const std::uint64_t tick = registry.advance_tick();
+        executor.run(
+            m_pools.size(),
+            [this, &baseline, since](std::size_t index)
+            {
+                ECS_PROFILE_SCOPE("ecs::DeltaEncoder::encode pool");
+                _encode_pool(m_pools[index], baseline, since, m_sections[index]);
+            }
+        );
+
+        DeltaHeader header = {};
+        header.tick = tick;
+        header.since = since;
+        std::size_t size = sizeof(DeltaHeader);
+        for (std::size_t i = 0; i < m_pools.size(); i++)
+        {
+            header.pool_count += !m_sections[i].empty();
+            size += m_sections[i].size();
+        }
+
+        out.clear();
+        out.reserve(size);
+        _append(out, &header, sizeof(DeltaHeader));
+        for (std::size_t i = 0; i < m_pools.size(); i++)
+            out.insert(out.end(), m_sections[i].begin(), m_sections[i].end());
+    }
+
+  private:
+    static inline void _append(std::vector<std::byte>& out, const void* data, std::size_t size)
+    {
+        const std::byte* bytes = static_cast<const std::byte*>(data);
+        out.insert(out.end(), bytes, bytes + size);
+    }
+
+    static inline void _pad(std::vector<std::byte>& out)
+    {
+        out.resize((out.size() + alignof(Entity) - 1) / alignof(Entity) * alignof(Entity));
+    }
+
+    /**
+     * @brief Leaves out empty when nothing of the pool changed
+     */
+    static void _encode_pool(
+        ObjectPool* pool, const ReplicationBaseline& baseline, std::uint64_t since,
+        std::vector<std::byte>& out
+    )
+    {
+        out.clear();
+        const std::uint64_t hash = pool->get_type_hash();
+        const std::size_t size = pool->get_type_size();
+
+        // Removed and added again since is sent as a change against the old baseline object
+        std::vector<Entity> removed = {};
+        for (const ObjectPoolRemoval& removal : pool->get_removed())
+        {
+            if (removal.tick > since && !pool->contains(removal.entity))
+                removed.push_back(removal.entity);
+        }
+
+        std::vector<std::size_t> changed = {};
+        for (std::size_t i = 0; i < pool->get_count(); i++)
+        {
+            if (pool->get_changed_tick(i) <= since)
+                continue;
+
+            const std::byte* base = baseline.find(hash, pool->get_dense_entities()[i]);
+            if (base == nullptr || std::memcmp(base, pool->get_object(i), size) != 0)
+                changed.push_back(i);
+        }
+
+        if (removed.empty() && changed.empty())
+            return;
+
+        DeltaPoolHeader header = {};
+        header.hash = hash;
+        header.type_size = size;
+        header.alignment = pool->get_type_alignment();
+        header.name_size = static_cast<std::uint32_t>(pool->get_name().size());
+        header.removed_count = removed.size();
+        header.count = changed.size();
+
+        _append(out, &header, sizeof(DeltaPoolHeader));
+        _append(out, pool->get_name().data(), header.name_size);
+        _pad(out);
+        _append(out, removed.data(), sizeof(Entity) * removed.size());
+        for (std::size_t index : changed)
+            _append(out, &pool->get_dense_entities()[index], sizeof(Entity));
+
+        std::size_t offset = out.size();
+        out.resize(offset + size * changed.size());
+        for (std::size_t index : changed)
+        {
+            const std::byte* object = pool->get_object(index);
+            const std::byte* base = baseline.find(hash, pool->get_dense_entities()[index]);
+            for (std::size_t k = 0; k < size; k++)
+                out[offset + k] = base != nullptr ? object[k] ^ base[k] : object[k];
+
+            offset += size;
+        }
+        _pad(out);
+    }
+
+  private:
+    std::vector<ObjectPool*> m_pools = {};
+    std::vector<std::vector<std::byte>> m_sections = {};
+};
+
+template<typename _T, typename _Fn>
+inline void Registry::par_propagate(_Fn fn, std::size_t grain_size)
+{
+    par_propagate<_T>(fn, ThreadPool::get_global(), grain_size);
+}
+
+/**
+ * @brief View filter matching entities whose _T changed after the tick the view was created
+ * with, see Registry::patch() and Registry::advance_tick(). Filters are not handed out
+ */
+template<typename _T>
+struct Changed
+{
+};
+
+/**
+ * @brief View filter matching entities that were given _T after the tick the view was created
+ * with
+ */
+template<typename _T>
+struct Added
+{
+};
+
+/**
+ * @brief View filter matching entities that don't have _T
+ */
+template<typename _T>
+struct Exclude
+{
+};
+
+/**
+ * @brief View argument handed out as a pointer to _T, or nullptr when the entity doesn't have
+ * one, without restricting which entities match
+ */
+template<typename _T>
+struct Optional
+{
+};
+
+/**
+ * @class ViewTerm
+ * @brief How an argument of a View is matched. Plain components are required and handed out as
+ * a pointer, filters only restrict which entities match
+ *
+ * required terms need the entity to be in the term's pool so it can drive the view, yielded
+ * terms are handed out as Type*, membership terms are fully checked by contains() and ticked
+ * terms compare against the tick the view was created with
+ */
+template<typename _T>
+struct ViewTerm
+{
+    using Type = _T;
+    using Component = std::remove_cv_t<_T>;
+
+    static constexpr bool required = true;
+    static constexpr bool yielded = true;
+    static constexpr bool membership = true;
+    static constexpr bool ticked = false;
+
+    static inline bool accept(const ObjectPool* pool, Entity entity, std::uint64_t)
+    {
+        return pool->contains(entity);
+    }
+};
+
+template<typename _T>
+struct ViewTerm<Changed<_T>>
+{
+    using Type = _T;
+    using Component = std::remove_cv_t<_T>;
+
+    static constexpr bool required = true;
+    static constexpr bool yielded = false;
+    static constexpr bool membership = false;
+    static constexpr bool ticked = true;
+
+    static inline bool accept(const ObjectPool* pool, Entity entity, std::uint64_t since)
+    {
+        const std::size_t index = pool->get_index(entity);
+        return index != std::string::npos && pool->get_changed_tick(index) > since;
+    }
+};
+
+template<typename _T>
+struct ViewTerm<Added<_T>>
+{
+    using Type = _T;
+    using Component = std::remove_cv_t<_T>;
+
+    static constexpr bool required = true;
+    static constexpr bool yielded = false;
+    static constexpr bool membership = false;
+    static constexpr bool ticked = true;
+
+    static inline bool accept(const ObjectPool* pool, Entity entity, std::uint64_t since)
+    {
+        const std::size_t index = pool->get_index(entity);
+        return index != std::string::npos && pool->get_added_tick(index) > since;
+    }
+};
+
+/**
+ * @brief A pool that doesn't exist yet can't contain the entity
+ */
+template<typename _T>
+struct ViewTerm<Exclude<_T>>
+{
+    using Type = _T;
+    using Component = std::remove_cv_t<_T>;
+
+    static constexpr bool required = false;
+    static constexpr bool yielded = false;
+    static constexpr bool membership = false;
+    static constexpr bool ticked = false;
+
+    static inline bool accept(const ObjectPool* pool, Entity entity, std::uint64_t)
+    {
+        return pool == nullptr || !pool->contains(entity);
+    }
+};
+
+template<typename _T>
+struct ViewTerm<Optional<_T>>
+{
+    using Type = _T;
+    using Component = std::remove_cv_t<_T>;
+
+    static constexpr bool required = false;
+    static constexpr bool yielded = true;
+    static constexpr bool membership = false;
+    static constexpr bool ticked = false;
+
+    static inline bool accept(const ObjectPool*, Entity, std::uint64_t) { return true; }
+};
+
+template<typename _T>
+using ViewPointer = _T*;
+
+template<typename _T>
+using ViewSpan = std::span<_T>;
+
+/**
+ * @brief std::tuple<_Wrapper<Type>> for yielded terms and an empty tuple for filters
+ */
+template<typename _Term, template<typename> typename _Wrapper>
+using ViewYield = std::conditional_t<
+    ViewTerm<_Term>::yielded, std::tuple<_Wrapper<typename ViewTerm<_Term>::Type>>, std::tuple<>>;
+
+/**
+ * @brief _Head followed by _Wrapper<Type> of every yielded term
+ */
+template<typename _Head, template<typename> typename _Wrapper, typename... _Ts>
+using ViewTuple = decltype(std::tuple_cat(
+    std::declval<std::tuple<_Head>>(), std::declval<ViewYield<_Ts, _Wrapper>>()...
+));
+
+/**
+ * @class ViewIterator
+ * @brief Walks the dense entities of the smallest required pool in a view and skips every
+ * entity that is missing one of the other components or is rejected by a filter. Dereferencing
+ * yields the entity followed by a pointer to each of its yielded components
+ */
+template<typename _T, typename... _Ts>
+class ViewIterator
+{
+  public:
+    using Pools = std::array<ObjectPool*, 1 + sizeof...(_Ts)>;
+    using Value = ViewTuple<Entity, ViewPointer, _T, _Ts...>;
+
+  public:
+    ViewIterator(const Pools& pools, ObjectPool* driver, std::size_t index)
+        : ViewIterator(pools, driver, index, driver != nullptr ? driver->get_count() : 0, 0)
+    {
+    }
+
+    /**
+     * @brief Iterator that never moves past the driver index end, used to split the driver into
+     * batches. since is the tick tick filters compare against
+     */
+    ViewIterator(
+        const Pools& pools, ObjectPool* driver, std::size_t index, std::size_t end,
+        std::uint64_t since = 0
+    )
+        : m_pools(pools), m_driver(driver), m_index(index), m_end(end), m_since(since)
+    {
+        _skip_forward();
+    }
+
+    ViewIterator(const ViewIterator& other)
+        : m_pools(other.m_pools), m_driver(other.m_driver), m_index(other.m_index),
+          m_end(other.m_end), m_since(other.m_since)
+    {
+    }
+
+    inline std::size_t get_index() const { return m_index; }
+
+    bool operator==(const ViewIterator& other) { return m_index == other.m_index; }
+    bool operator!=(const ViewIterator& other) { return m_index != other.m_index; }
+    Value operator*() { return _get(std::index_sequence_for<_T, _Ts...>{}); }
+
+    ViewIterator& operator++()
+    {
+        m_index++;
+        _skip_forward();
+        return *this;
+    }
+
+    ViewIterator& operator--()
+    {
+        do
+            m_index--;
+        while (m_index > 0 && !_has_required());
+
+        return *this;
+    }
+
+    ViewIterator operator++(int)
+    {
+        ViewIterator iter = *this;
+        ++(*this);
+        return iter;
+    }
+
+    ViewIterator operator--(int)
+    {
+        ViewIterator iter = *this;
+        --(*this);
+        return iter;
+    }
+
+  private:
+    bool _has_required() const
+    {
+        m_driver->record_iterations(1);
+
+        Entity entity = m_driver->get_dense_entities()[m_index];
+        return _accept(entity, std::index_sequence_for<_T, _Ts...>{});
+    }
+
+    template<std::size_t... _Indices>
+    inline bool _accept(Entity entity, std::index_sequence<_Indices...>) const
+    {
+        return (_accept_term<_Indices>(entity) && ...);
+    }
+
+    /**
+     * @brief The driver already contains the entity so membership terms over it pass
+     */
+    template<std::size_t _Index>
+    inline bool _accept_term(Entity entity) const
+    {
+        using Term = ViewTerm<std::tuple_element_t<_Index, std::tuple<_T, _Ts...>>>;
+
+        const ObjectPool* pool = std::get<_Index>(m_pools);
+        if constexpr (Term::membership && Term::required)
+        {
+            if (pool == m_driver)
+                return true;
+        }
+
+        return Term::accept(pool, entity, m_since);
+    }
+
+    void _skip_forward()
+    {
+        while (m_index < m_end && !_has_required())
+            m_index++;
+    }
+
+    template<std::size_t... _Indices>
+    Value _get(std::index_sequence<_Indices...>)
+    {
+        Entity entity = m_driver->get_dense_entities()[m_index];
+        return std::tuple_cat(std::tuple<Entity>(entity), _yield<_Indices>(entity)...);
+    }
+
+    template<std::size_t _Index>
+    inline auto _yield(Entity entity)
+    {
+        using Term = ViewTerm<std::tuple_element_t<_Index, std::tuple<_T, _Ts...>>>;
+
+        if constexpr (Term::yielded)
+        {
+            std::byte* object = _get_object<Term>(std::get<_Index>(m_pools), entity);
+            return std::tuple<typename Term::Type*>(reinterpret_cast<typename Term::Type*>(object));
+        }
+        else
+            return std::tuple<>();
+    }
+
+    /**
+     * @brief The driver already knows the dense index so only the other pools need a sparse
+     * lookup, optional terms may have no pool or no object for the entity
+     */
+    template<typename _Term>
+    inline std::byte* _get_object(ObjectPool* pool, Entity entity)
+    {
+        if constexpr (!_Term::required)
+            return pool != nullptr ? pool->get_entitys_object(entity) : nullptr;
+        else if (pool == m_driver)
+            return pool->get_object(m_index);
+        else
+            return pool->get_object(pool->get_index(entity));
+    }
+
+  private:
+    Pools m_pools = {};
+    ObjectPool* m_driver = nullptr;
+    std::size_t m_index = 0;
+    std::size_t m_end = 0;
+    std::uint64_t m_since = 0;
+};
+
+/**
+ * @class ViewChunkIterator
+ * @brief Walks a view in batches of entities whose components are stored next to each other in
+ * every pool. Dereferencing yields a span of the entities followed by a span of each yielded
+ * component
+ *
+ * Batches only grow past one entity when every yielded pool is packed and the entities keep the
+ * same relative order in all of them, which is always true for single component views
+ */
+template<typename _T, typename... _Ts>
+class ViewChunkIterator
+{
+  public:
+    using Pools = std::array<ObjectPool*, 1 + sizeof...(_Ts)>;
+    using Value = ViewTuple<std::span<const Entity>, ViewSpan, _T, _Ts...>;
+
+  public:
+    ViewChunkIterator(
+        const Pools& pools, ObjectPool* driver, std::size_t index, std::uint64_t since = 0
+    )
+        : m_pools(pools), m_driver(driver), m_begin(index), m_since(since)
+    {
+        m_packed = true;
+        for (std::size_t i = 0; i < m_pools.size(); i++)
+        {
+            if (s_yielded[i] && m_pools[i] != nullptr &&
+                m_pools[i]->get_layout() != ObjectPoolLayout::Packed)
+                m_packed = false;
+        }
+
+        _find_chunk();
+    }
+
+    bool operator==(const ViewChunkIterator& other) { return m_begin == other.m_begin; }
+    bool operator!=(const ViewChunkIterator& other) { return m_begin != other.m_begin; }
+
+    Value operator*() { return _get(std::index_sequence_for<_T, _Ts...>{}); }
+
+    ViewChunkIterator& operator++()
+    {
+        m_begin = m_end;
+        _find_chunk();
+        return *this;
+    }
+
+  private:
+    static constexpr std::array<bool, 1 + sizeof...(_Ts)> s_yielded = {
+        ViewTerm<_T>::yielded,
+        ViewTerm<_Ts>::yielded...,
+    };
+
+    inline std::size_t _count() const { return m_driver != nullptr ? m_driver->get_count() : 0; }
+
+    /**
+     * @brief Dense index of the entity in the pool of every yielded term, false if one of them
+     * doesn't contain it or a filter rejects it
+     */
+    bool _get_indices(std::size_t driver_index, std::array<std::size_t, 1 + sizeof...(_Ts)>& out)
+    {
+        m_driver->record_iterations(1);
+
+        Entity entity = m_driver->get_dense_entities()[driver_index];
+        return _get_term_indices(entity, driver_index, out, std::index_sequence_for<_T, _Ts...>{});
+    }
+
+    template<std::size_t... _Indices>
+    inline bool _get_term_indices(
+        Entity entity, std::size_t driver_index, std::array<std::size_t, 1 + sizeof...(_Ts)>& out,
+        std::index_sequence<_Indices...>
+    )
+    {
+        return (_get_term_index<_Indices>(entity, driver_index, out[_Indices]) && ...);
+    }
+
+    template<std::size_t _Index>
+    inline bool _get_term_index(Entity entity, std::size_t driver_index, std::size_t& out)
+    {
+        using Term = ViewTerm<std::tuple_element_t<_Index, std::tuple<_T, _Ts...>>>;
+
+        ObjectPool* pool = std::get<_Index>(m_pools);
+        out = 0;
+        if constexpr (!Term::membership)
+        {
+            if (!Term::accept(pool, entity, m_since))
+                return false;
+        }
+
+        if constexpr (Term::yielded)
+        {
+            out = pool == m_driver ? driver_index : pool->get_index(entity);
+            return out != std::string::npos;
+        }
+        else if constexpr (Term::membership)
+            return Term::accept(pool, entity, m_since);
+        else
+            return true;
+    }
+
+    void _find_chunk()
+    {
+        const std::size_t count = _count();
+        while (m_begin < count && !_get_indices(m_begin, m_indices))
+            m_begin++;
+
+        m_end = m_begin < count ? m_begin + 1 : count;
+        if (!m_packed)
+            return;
+
+        std::array<std::size_t, 1 + sizeof...(_Ts)> next = {};
+        for (; m_end < count && _get_indices(m_end, next); m_end++)
+        {
+            for (std::size_t i = 0; i < m_pools.size(); i++)
+            {
+                if (next[i] != m_indices[i] + (s_yielded[i] ? m_end - m_begin : 0))
+                    return;
+            }
+        }
+    }
+
+    template<std::size_t _Index>
+    inline auto _get_span()
+    {
+        using Term = ViewTerm<std::tuple_element_t<_Index, std::tuple<_T, _Ts...>>>;
+
+        if constexpr (Term::yielded)
+        {
+            using Type = typename Term::Type;
+
+            ObjectPool* pool = std::get<_Index>(m_pools);
+            Type* data = reinterpret_cast<Type*>(pool->get_object(std::get<_Index>(m_indices)));
+            return std::tuple<std::span<Type>>(std::span<Type>(data, m_end - m_begin));
+        }
+        else
+            return std::tuple<>();
+    }
+
+    template<std::size_t... _Indices>
+    Value _get(std::index_sequence<_Indices...>)
+    {
+        return std::tuple_cat(
+            std::tuple<std::span<const Entity>>(std::span<const Entity>(
+                m_driver->get_dense_entities().data() + m_begin, m_end - m_begin
+            )),
+            _get_span<_Indices>()...
+        );
+    }
+
+  private:
+    Pools m_pools = {};
+    ObjectPool* m_driver = nullptr;
+    bool m_packed = false;
+    std::size_t m_begin = 0;
+    std::size_t m_end = 0;
+    std::uint64_t m_since = 0;
+    std::array<std::size_t, 1 + sizeof...(_Ts)> m_indices = {};
+};
+
+/**
+ * @class ViewChunks
+ * @brief Range returned by View::chunks()
+ */
+template<typename _T, typename... _Ts>
+class ViewChunks
+{
+  public:
+    using Iterator = ViewChunkIterator<_T, _Ts...>;
+
+  public:
+    ViewChunks(const typename Iterator::Pools& pools, ObjectPool* driver, std::uint64_t since = 0)
+        : m_pools(pools), m_driver(driver), m_since(since)
+    {
+    }
+
+    inline Iterator begin() { return Iterator(m_pools, m_driver, 0, m_since); }
+
+    inline Iterator end()
+    {
+        return Iterator(
+            m_pools, m_driver, m_driver != nullptr ? m_driver->get_count() : 0, m_since
+        );
+    }
+
+  private:
+    typename Iterator::Pools m_pools = {};
+    ObjectPool* m_driver = nullptr;
+    std::uint64_t m_since = 0;
+};
+
+/**
+ * @class View
+ * @brief Entities owning every component of the view. Arguments can also be filters such as
+ * Exclude<_T>, Changed<_T> and Added<_T>, which aren't handed out, and Optional<_T>, which is
+ * handed out as nullptr for entities without _T. All of them are checked in O(1) per entity
+ */
+template<typename _T, typename... _Ts>
+class View
+{
+  public:
+    using Iterator = ViewIterator<_T, _Ts...>;
+    using Pointers = decltype(std::tuple_cat(
+        std::declval<ViewYield<_T, ViewPointer>>(), std::declval<ViewYield<_Ts, ViewPointer>>()...
+    ));
+
+  public:
+    /**
+     * @brief since is the tick Changed and Added filters compare against, see
+     * Registry::advance_tick()
+     */
+    View(Registry* registry, std::uint64_t since = 0) : m_registry(registry), m_since(since)
+    {
+        _resolve_pools();
+    }
+
+    /**
+     * @brief View over pools that were already looked up in argument order, see
+     * StaticRegistry::view()
+     */
+    View(Registry* registry, const typename Iterator::Pools& pools, std::uint64_t since = 0)
+        : m_registry(registry), m_since(since), m_pools(pools),
+          m_resolved(std::find(pools.begin(), pools.end(), nullptr) == pools.end())
+    {
+        _resolve_pools();
+    }
+
+    ~View() = default;
+
+    /**
+     * @brief Iterates over the entities matching every argument of the view, driven by whichever
+     * of the required pools holds the fewest objects
+     */
+    inline Iterator begin()
+    {
+        _resolve_pools();
+        ObjectPool* driver = _get_driver();
+        return Iterator(m_pools, driver, 0, driver != nullptr ? driver->get_count() : 0, m_since);
+    }
+
+    inline Iterator end()
+    {
+        _resolve_pools();
+        ObjectPool* driver = _get_driver();
+        const std::size_t count = driver != nullptr ? driver->get_count() : 0;
+        return Iterator(m_pools, driver, count, count, m_since);
+    }
+
+    /**
+     * @brief Batches of (span<const Entity>, span<_T>, span<_Ts>...) covering the same entities
+     * as iterating the view, for kernels that work on whole component arrays at once. See
+     * ViewChunkIterator for when batches are larger than a single entity
+     */
+    inline ViewChunks<_T, _Ts...> chunks()
+    {
+        static_assert(
+            (ViewTerm<_T>::required || !ViewTerm<_T>::yielded) &&
+                ((ViewTerm<_Ts>::required || !ViewTerm<_Ts>::yielded) && ...),
+            "ECS ASSERT: Optional components have no contiguous span and can't be used in chunks()"
+        );
+
+        _resolve_pools();
+        return ViewChunks<_T, _Ts...>(m_pools, _get_driver(), m_since);
+    }
+
+    /**
+     * @brief Calls fn(entity, pointers...) with a pointer to every yielded component of each
+     * entity matching the view
+     */
+    template<typename _Fn>
+    void each(_Fn fn)
+    {
+        ECS_PROFILE_SCOPE("ecs::View::each");
+        for (Iterator it = begin(), last = end(); it != last; ++it)
+            std::apply(fn, *it);
+    }
+
+    /**
+     * @brief Same as each() except the driver pool is split into batches of grain_size objects
+     * that are run on the global ThreadPool. fn is called concurrently so it must not create or
+     * destroy components of the viewed pools
+     */
+    template<typename _Fn>
+    void par_each(_Fn fn, std::size_t grain_size = ECS_VIEW_DEFAULT_GRAIN_SIZE)
+    {
+        par_each(fn, ThreadPool::get_global(), grain_size);
+    }
+
+    /**
+     * @brief par_each() using the given executor, it has to provide run(count, job) which calls
+     * job(index) for each index in [0, count) and returns once every call has finished
+     */
+    template<typename _Fn, typename _Executor>
+    void par_each(_Fn fn, _Executor& executor, std::size_t grain_size = ECS_VIEW_DEFAULT_GRAIN_SIZE)
+    {
+        assert(grain_size > 0 && "ECS ASSERT: grain_size must be larger than 0");
+        ECS_PROFILE_SCOPE("ecs::View::par_each");
+
+        _resolve_pools();
+        ObjectPool* driver = _get_driver();
+        if (driver == nullptr)
+            return;
+
+        const typename Iterator::Pools pools = m_pools;
+        const std::size_t count = driver->get_count();
+        const std::size_t batch_count = (count + grain_size - 1) / grain_size;
+        const std::uint64_t since = m_since;
+
+        executor.run(
+            batch_count,
+            [&pools, &fn, driver, count, grain_size, since](std::size_t batch)
+            {
+                ECS_PROFILE_SCOPE("ecs::View::par_each batch");
+                const std::size_t last = std::min(count, (batch + 1) * grain_size);
+                for (Iterator it = Iterator(pools, driver, batch * grain_size, last, since);
+                     it.get_index() < last; ++it)
+                    std::apply(fn, *it);
+            }
+        );
+    }
+
+    Pointers get() { return m_reserved_from_valid; }
+
+    template<typename _Target>
+    _Target* get()
+    {
+        return std::get<_Target*>(m_reserved_from_valid);
+    }
+
+    bool has_required(Entity entity)
+    {
+        m_reserved_from_valid = {};
+        if (entity == ECS_ENTITY_DESTROYED)
+            return false;
+
+        _resolve_pools();
+        if (_get_driver() == nullptr || !_accept(entity, std::index_sequence_for<_T, _Ts...>{}))
+            return false;
+
+        m_reserved_from_valid = _fill_result(entity, std::index_sequence_for<_T, _Ts...>{});
+        return true;
+    }
+
+  private:
+    static constexpr std::array<bool, 1 + sizeof...(_Ts)> s_required = {
+        ViewTerm<_T>::required,
+        ViewTerm<_Ts>::required...,
+    };
+
+    /**
+     * @brief Looks up the pools of the view once, only retrying while one of them hasn't been
+     * created by the registry yet
+     */
+    inline void _resolve_pools()
+    {
+        if (!m_resolved)
+        {
+            m_pools = {
+                m_registry->get_pool<typename ViewTerm<_T>::Component>(),
+                m_registry->get_pool<typename ViewTerm<_Ts>::Component>()...,
+            };
+            m_resolved = std::find(m_pools.begin(), m_pools.end(), nullptr) == m_pools.end();
+        }
+    }
+
+    /**
+     * @brief Smallest of the required pools, nullptr when one of them doesn't exist as then no
+     * entity can match
+     */
+    ObjectPool* _get_driver() const
+    {
+        ObjectPool* driver = nullptr;
+        for (std::size_t i = 0; i < m_pools.size(); i++)
+        {
+            ObjectPool* pool = m_pools[i];
+            if (!s_required[i])
+                continue;
+            else if (pool == nullptr)
+                return nullptr;
+            else if (driver == nullptr || pool->get_count() < driver->get_count())
+                driver = pool;
+        }
+
+        return driver;
+    }
+
+    template<std::size_t... _Indices>
+    inline bool _accept(Entity entity, std::index_sequence<_Indices...>) const
+    {
+        return (
+            ViewTerm<std::tuple_element_t<_Indices, std::tuple<_T, _Ts...>>>::accept(
+                std::get<_Indices>(m_pools), entity, m_since
+            ) &&
+            ...
+        );
+    }
+
+    template<std::size_t _Index>
+    inline auto _fill_term(Entity entity)
+    {
+        using Term = ViewTerm<std::tuple_element_t<_Index, std::tuple<_T, _Ts...>>>;
+
+        if constexpr (Term::yielded)
+        {
+            ObjectPool* pool = std::get<_Index>(m_pools);
+            return std::tuple<typename Term::Type*>(reinterpret_cast<typename Term::Type*>(
+                pool != nullptr ? pool->get_entitys_object(entity) : nullptr
+            ));
         }
         else
-            m_next = reinterpret_cast<ObjectPoolChunk*>(block);
+            return std::tuple<>();
     }
 
-  protected:
-    const std::string m_type_name = "";
-    const std::size_t m_type_size = 0;
-    const std::uint64_t m_type_hash = 0;
-    const std::size_t m_block_size = 0;
-    std::list<std::byte*> m_blocks = {};
-    ObjectPoolChunk* m_next = nullptr;
-    std::vector<ObjectPoolChunk*> m_freed_locations = {};
-    fnptr_objectpool_type_default_constructor m_type_default_constructor = nullptr;
-    fnptr_objectpool_type_deconstructor m_type_deconstructor = nullptr;
+    template<std::size_t... _Indices>
+    Pointers _fill_result(Entity entity, std::index_sequence<_Indices...>)
+    {
+        return std::tuple_cat(_fill_term<_Indices>(entity)...);
+    }
+
+  private:
+    Registry* m_registry = nullptr;
+    std::uint64_t m_since = 0;
+    typename Iterator::Pools m_pools = {};
+    bool m_resolved = false;
+    Pointers m_reserved_from_valid = {};
 };
 
-class Registry
+/**
+ * @class GroupIterator
+ * @brief Walks the aligned front of the pools owned by a group, the entity and all of its
+ * components are at the same dense index in every pool so nothing is looked up
+ */
+template<typename _T, typename... _Ts>
+class GroupIterator
 {
   public:
-    Registry() {}
+    using Pools = std::array<ObjectPool*, 1 + sizeof...(_Ts)>;
+    using Value = std::tuple<Entity, _T*, _Ts*...>;
 
-    ~Registry()
+  public:
+    GroupIterator(const Pools& pools, std::size_t index) : m_pools(pools), m_index(index) {}
+
+    inline std::size_t get_index() const { return m_index; }
+
+    bool operator==(const GroupIterator& other) { return m_index == other.m_index; }
+    bool operator!=(const GroupIterator& other) { return m_index != other.m_index; }
+    Value operator*() { return _get(std::index_sequence_for<_T, _Ts...>{}); }
+
+    GroupIterator& operator++()
     {
-        for (ObjectPool* pool : m_pools)
-            delete pool;
+        m_index++;
+        return *this;
     }
 
-    Entity create_entity()
+    GroupIterator operator++(int)
     {
-        // PERF: Improve the destroyed entities system so that it is not poping back
-        if (m_destroyed_entities.size() > 0)
-        {
-            std::size_t id = m_destroyed_entities.back();
+        GroupIterator iter = *this;
+        m_index++;
+        return iter;
+    }
 
-            Entity entity = Entity{id};
-            m_entities[id] = entity;
+  private:
+    template<std::size_t... _Indices>
+    Value _get(std::index_sequence<_Indices...>)
+    {
+        return Value(
+            m_pools[0]->get_dense_entities()[m_index],
+            reinterpret_cast<std::tuple_element_t<_Indices, std::tuple<_T, _Ts...>>*>(
+                std::get<_Indices>(m_pools)->get_object(m_index)
+            )...
+        );
+    }
 
-            m_destroyed_entities.pop_back();
+  private:
+    Pools m_pools = {};
+    std::size_t m_index = 0;
+};
 
-            return m_entities[entity];
-        }
-        else
-        {
-            m_entities.push_back(Entity{m_entities.size()});
+/**
+ * @class Group
+ * @brief Entities owning every component of an owning group, see Registry::group(). Iterating
+ * yields the same tuples as View<_T, _Ts...> but walks parallel arrays without any lookups
+ */
+template<typename _T, typename... _Ts>
+class Group
+{
+  public:
+    using Iterator = GroupIterator<_T, _Ts...>;
 
-            return m_entities.back();
-        }
+  public:
+    Group(ObjectPoolGroup* owner, const typename Iterator::Pools& pools)
+        : m_owner(owner), m_pools(pools)
+    {
     }
 
-    inline std::vector<Entity>& get_entities() { return m_entities; }
-    inline std::vector<ObjectPool*>& get_pools() { return m_pools; }
-    inline const std::vector<Entity>& get_entities() const { return m_entities; }
-    inline const std::vector<ObjectPool*>& get_pools() const { return m_pools; }
+    inline std::size_t size() const { return m_owner->get_size(); }
+    inline Iterator begin() { return Iterator(m_pools, 0); }
+    inline Iterator end() { return Iterator(m_pools, size()); }
 
-    template<typename _T>
-    inline ObjectPool* get_pool()
+    inline std::span<const Entity> get_entities() const
     {
-        return get_pool(type_descriptor::get_hash(type_descriptor::get_name<_T>()));
+        return std::span<const Entity>(m_pools[0]->get_dense_entities().data(), size());
     }
 
-    template<typename _T>
-    inline const ObjectPool* get_pool() const
+    /**
+     * @brief Components of every entity in the group in the order of get_entities(), only for
+     * packed pools
+     */
+    template<typename _Target>
+    std::span<_Target> data()
     {
-        return get_pool(type_descriptor::get_hash(type_descriptor::get_name<_T>()));
+        ObjectPool* pool = std::get<_index_of<_Target, _T, _Ts...>()>(m_pools);
+        assert(
+            pool->get_layout() == ObjectPoolLayout::Packed &&
+            "ECS ASSERT (data()): only packed pools store their objects contiguously"
+        );
+
+        return std::span<_Target>(pool->template data<_Target>(), size());
     }
 
-    inline const ObjectPool* get_pool(std::uint64_t hash) const { return get_pool(hash); }
+    /**
+     * @brief Calls fn(entity, _T*, _Ts*...) for every entity in the group
+     */
+    template<typename _Fn>
+    void each(_Fn fn)
+    {
+        ECS_PROFILE_SCOPE("ecs::Group::each");
+        for (Iterator it = begin(), last = end(); it != last; ++it)
+            std::apply(fn, *it);
+    }
 
-    ObjectPool* get_pool(std::uint64_t hash)
+  private:
+    template<typename _Target, typename _First, typename... _Rest>
+    static constexpr std::size_t _index_of()
     {
-        for (ObjectPool* pool : m_pools)
+        if constexpr (std::is_same_v<std::remove_cv_t<_Target>, std::remove_cv_t<_First>>)
+            return 0;
+        else
         {
-            if (pool->get_type_hash() == hash)
-                return pool;
+            static_assert(sizeof...(_Rest) > 0, "ECS ASSERT: type is not part of the group");
+            return 1 + _index_of<_Target, _Rest...>();
         }
+    }
 
-        return nullptr;
+  private:
+    ObjectPoolGroup* m_owner = nullptr;
+    typename Iterator::Pools m_pools = {};
+};
+
+/**
+ * @class StaticRegistry
+ * @brief Registry whose component set is known at compile time. The pools of _Ts are created up
+ * front and stored by their position in _Ts, so the typed functions below and view() resolve
+ * them with a constant index instead of a type lookup. Every other type, including those of the
+ * runtime create_component() path, still goes through the Registry it derives from
+ *
+ * The functions hide those of Registry rather than override them, code holding a Registry& to
+ * a StaticRegistry finds the same pools through the regular lookup
+ */
+template<typename... _Ts>
+class StaticRegistry : public Registry
+{
+  public:
+    using Registry::create_component;
+    using Registry::destroy_component;
+    using Registry::get_component;
+    using Registry::get_pool;
+
+    StaticRegistry(
+        std::pmr::memory_resource* resource = std::pmr::get_default_resource(),
+        ObjectPoolLayout layout = ObjectPoolLayout::Chunked
+    )
+        : Registry(resource), m_static_pools({create_pool<_Ts>(layout)...})
+    {
     }
 
     template<typename _T>
-    _T* get_component(Entity entity)
+    static constexpr bool contains()
     {
-        ObjectPool* pool = get_pool<_T>();
-        if (pool != nullptr)
-            return pool->get_entitys_object<_T>(entity);
-
-        return nullptr;
+        return (std::is_same_v<std::remove_cv_t<_T>, _Ts> || ...);
     }
 
-    void* get_component(Entity entity, std::uint64_t hash)
+    /**
+     * @brief Position of _T in _Ts
+     */
+    template<typename _T>
+    static constexpr std::size_t index_of()
     {
-        ObjectPool* pool = get_pool(hash);
-        if (pool != nullptr)
-        {
-            ObjectPoolChunk* chunk = pool->get_entitys_object_pool_chunk(entity);
-            if (chunk != nullptr)
-            {
-                std::byte* byte_data = reinterpret_cast<std::byte*>(chunk);
-                return reinterpret_cast<void*>(byte_data + sizeof(ObjectPoolChunk));
-            }
-        }
-        return nullptr;
+        static_assert(contains<_T>(), "ECS ASSERT: type isn't part of the StaticRegistry");
+
+        constexpr bool matches[] = {std::is_same_v<std::remove_cv_t<_T>, _Ts>...};
+        std::size_t index = 0;
+        while (!matches[index])
+            index++;
+
+        return index;
     }
 
-    const void* get_component(Entity entity, std::uint64_t hash) const
+    template<typename _T>
+    inline ObjectPool* get_pool()
     {
-        return get_component(entity, hash);
+        if constexpr (contains<_T>())
+            return m_static_pools[index_of<_T>()];
+        else
+            return Registry::get_pool<_T>();
     }
 
-    void destroy_entity(Entity entity)
+    template<typename _T>
+    inline const ObjectPool* get_pool() const
     {
-        assert(
-            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (destroy_entity(entity)): entity "
-                                              "provided id is set to ECS_Entity_DESTRSOYED"
-        );
-        assert(
-            entity < m_entities.size() && "ECS ASSERT (destroy_entity(entity)): entity provided id "
-                                          "is greater than m_entities.size()"
-        );
-
-        m_destroyed_entities.push_back(entity);
-        m_entities[entity] = ECS_ENTITY_DESTROYED;
-
-        for (ObjectPool* pool : m_pools)
-        {
-            // PERF: Improve so it isn't doing a linear search
-            ObjectPoolChunk* chunk = pool->get_entitys_object_pool_chunk(entity);
+        return const_cast<StaticRegistry*>(this)->get_pool<_T>();
+    }
 
-            if (chunk != nullptr)
-            {
-                if (chunk->entity == entity)
-                    pool->free(chunk);
-            }
-        }
+    template<typename _T>
+    inline _T* get_component(Entity entity)
+    {
+        ObjectPool* pool = get_pool<_T>();
+        return pool != nullptr ? pool->get_entitys_object<_T>(entity) : nullptr;
     }
 
     template<typename _T, typename... _Args>
-    _T* create_component(Entity entity, _Args... args)
+    _T* create_component(Entity entity, _Args&&... args)
     {
-        assert(
-            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (create_component(entity, ...)): cannot "
-                                              "create component onto destroyed entity"
-        );
-
-        ObjectPool* target = get_pool<_T>();
-        if (target == nullptr)
+        if constexpr (contains<_T>())
         {
-            target = ObjectPool::create<_T>(ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE);
-            m_pools.push_back(target);
+            assert(
+                entity != ECS_ENTITY_DESTROYED &&
+                "ECS ASSERT (create_component(entity, ...)): cannot create component onto "
+                "destroyed entity"
+            );
+            return get_pool<_T>()->template malloc<_T>(entity, std::forward<_Args>(args)...);
         }
+        else
+            return Registry::create_component<_T>(entity, std::forward<_Args>(args)...);
+    }
 
-        return target->malloc<_T>(entity, args...);
+    template<typename _T>
+    inline bool destroy_component(Entity entity)
+    {
+        if constexpr (contains<_T>() && !std::is_same_v<std::remove_cv_t<_T>, Relationship>)
+            return m_static_pools[index_of<_T>()]->free(entity);
+        else
+            return Registry::destroy_component<_T>(entity);
     }
 
-    std::byte* create_component(
-        Entity entity, std::uint64_t id, const std::string& name, std::size_t size,
-        fnptr_objectpool_type_deconstructor deconstructor,
-        fnptr_objectpool_type_default_constructor default_constsructor,
-        std::size_t block_size = ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE
-    )
+    /**
+     * @brief View with every pool of _Vs in _Ts resolved at compile time, the others are looked up
+     * once here. See View for the arguments
+     */
+    template<typename _V, typename... _Vs>
+    View<_V, _Vs...> view(std::uint64_t since = 0)
     {
-        assert(
-            entity != ECS_ENTITY_DESTROYED && "ECS ASSERT (create_component(entity, ...)): cannot "
-                                              "create component onto destroyed entity"
+        return View<_V, _Vs...>(
+            this,
+            {get_pool<typename ViewTerm<_V>::Component>(),
+             get_pool<typename ViewTerm<_Vs>::Component>()...},
+            since
         );
-
-        ObjectPool* target = get_pool(id);
-        if (target == nullptr)
-        {
-            target = new ObjectPool(name, size, id, block_size);
-            target->set_deconstructor(deconstructor);
-            target->set_default_constructor(default_constsructor);
-            m_pools.push_back(target);
-        }
-
-        return target->malloc(entity);
     }
 
   private:
-    std::vector<Entity> m_entities = {};
-    std::vector<std::size_t> m_destroyed_entities = {};
-    std::vector<ObjectPool*> m_pools = {};
+    std::array<ObjectPool*, sizeof...(_Ts)> m_static_pools = {};
 };
 
-template<typename _T, typename... _Ts>
-class ViewIterator
+/**
+ * @brief Components a Scheduler system only reads from
+ */
+template<typename... _Ts>
+struct Reads
 {
-  public:
-    ViewIterator(std::vector<Entity>::iterator iter) : m_iter(iter) {}
-    ViewIterator(const ViewIterator& other) : m_iter(other.m_iter) {}
+};
 
-    bool operator==(const ViewIterator& other) { return m_iter == other.m_iter; }
-    bool operator!=(const ViewIterator& other) { return m_iter != other.m_iter; }
-    Entity& operator*() { return *m_iter; }
-    Entity* operator->() { return &*m_iter; }
+/**
+ * @brief Components a Scheduler system reads from and writes to
+ */
+template<typename... _Ts>
+struct Writes
+{
+};
 
-    ViewIterator& operator++()
+/**
+ * @class SystemAccess
+ * @brief Type indices (see type_descriptor::get_index()) of the components a system touches
+ */
+struct SystemAccess
+{
+    std::vector<std::size_t> reads = {};
+    std::vector<std::size_t> writes = {};
+
+    template<typename... _Reads, typename... _Writes>
+    static SystemAccess create(Reads<_Reads...>, Writes<_Writes...>)
     {
-        m_iter++;
-        return *this;
+        return SystemAccess{
+            {type_descriptor::get_index<std::remove_cv_t<_Reads>>()...},
+            {type_descriptor::get_index<std::remove_cv_t<_Writes>>()...},
+        };
     }
 
-    ViewIterator& operator--()
+    /**
+     * @brief Const qualified components are reads and every other component a write, this
+     * matches what a View with the same template arguments hands out
+     */
+    template<typename... _Ts>
+    static SystemAccess create_from_view()
     {
-        m_iter--;
-        return *this;
+        SystemAccess access = {};
+        (access._add<_Ts>(), ...);
+        return access;
     }
 
-    ViewIterator operator++(int)
+    /**
+     * @brief Two systems conflict when either one writes a component the other one touches
+     */
+    bool conflicts(const SystemAccess& other) const
     {
-        ViewIterator iter = *this;
-        ++(*this);
-        return iter;
+        for (std::size_t write : writes)
+        {
+            if (other._touches(write))
+                return true;
+        }
+
+        for (std::size_t write : other.writes)
+        {
+            if (_touches(write))
+                return true;
+        }
+
+        return false;
     }
 
-    ViewIterator operator--(int)
+  private:
+    /**
+     * @brief Filters only look at the pool of their component so they count as reads
+     */
+    template<typename _T>
+    inline void _add()
     {
-        ViewIterator iter = *this;
-        --(*this);
-        return iter;
+        using Term = ViewTerm<_T>;
+
+        const std::size_t index = type_descriptor::get_index<typename Term::Component>();
+        if constexpr (!Term::yielded || std::is_const_v<typename Term::Type>)
+            reads.push_back(index);
+        else
+            writes.push_back(index);
     }
 
-  private:
-    std::vector<Entity>::iterator m_iter;
+    inline bool _touches(std::size_t index) const
+    {
+        return std::find(reads.begin(), reads.end(), index) != reads.end() ||
+               std::find(writes.begin(), writes.end(), index) != writes.end();
+    }
 };
 
-template<typename _T, typename... _Ts>
-class View
+/**
+ * @class Scheduler
+ * @brief Runs systems in the order they were added, except systems that don't conflict over
+ * component access run concurrently. Each run() orders the systems into waves where every
+ * system only depends on systems from earlier waves, then runs every wave through the executor
+ *
+ * Systems run at the same time as others so they must not create or destroy entities and
+ * components, record those changes and apply them after run() instead
+ */
+class Scheduler
 {
   public:
-    using Iterator = ViewIterator<_T, _Ts...>;
+    typedef std::function<void(Registry&)> System;
 
   public:
-    View(Registry* registry) : m_registry(registry)
+    Scheduler(Registry* registry) : m_registry(registry) {}
+
+    /**
+     * @brief Adds a system that is given the registry and only touches the declared components
+     */
+    template<typename... _Reads, typename... _Writes>
+    void add_system(Reads<_Reads...> reads, Writes<_Writes...> writes, const System& system)
     {
-        if constexpr (sizeof...(_Ts) > 0)
-            _count_types<_T, _Ts...>();
-        else
-            m_type_count = 1;
+        add_system(SystemAccess::create(reads, writes), system);
     }
 
-    ~View() = default;
-
-    inline Iterator begin() { return Iterator(m_registry->get_entities().begin()); }
-    inline Iterator end() { return Iterator(m_registry->get_entities().end()); }
-
-    std::tuple<_T*, _Ts*...> get() { return m_reserved_from_valid; }
-
-    template<typename _Target>
-    _Target* get()
+    void add_system(const SystemAccess& access, const System& system)
     {
-        return std::get<_Target*>(m_reserved_from_valid);
+        m_systems.push_back(Entry{access, system});
     }
 
-    bool has_required(Entity entity)
+    /**
+     * @brief Adds a system that calls fn(entity, _T*, _Ts*...) for every entity in View<_T,
+     * _Ts...>, the access is derived from the const qualification of the view types. Views with
+     * Changed or Added filters only see the changes made since the system's previous run
+     */
+    template<typename _T, typename... _Ts, typename _Fn>
+    void add_view_system(_Fn fn)
     {
-        if (entity == ECS_ENTITY_DESTROYED)
-            return false;
-
-        m_reserved_from_valid = {};
-        if constexpr (sizeof...(_Ts) > 0)
-        {
-            std::size_t found_types_count = 0;
-            fill_result<_T, _Ts...>(entity, 0, found_types_count);
+        constexpr bool filtered = ViewTerm<_T>::ticked || (ViewTerm<_Ts>::ticked || ...);
 
-            if (found_types_count == m_type_count)
-                return true;
-        }
-        else
-        {
-            // PERF: Improve so it is not linearly searching for components from the beginning of
-            // the pool for every entity
-            ObjectPool* target_pool = m_registry->get_pool<_T>();
-            if (target_pool != nullptr)
+        add_system(
+            SystemAccess::create_from_view<_T, _Ts...>(),
+            [fn, last_run = std::uint64_t(0)](Registry& registry) mutable
             {
-                _T* target_ptr = target_pool->get_entitys_object<_T>(entity);
-                if (target_ptr != nullptr)
+                std::uint64_t since = 0;
+                if constexpr (filtered)
                 {
-                    std::get<0>(m_reserved_from_valid) = target_ptr;
-                    return true;
+                    since = last_run;
+                    last_run = registry.advance_tick();
                 }
-            }
-        }
 
-        return false;
+                View<_T, _Ts...>(&registry, since).each(fn);
+            }
+        );
     }
 
-  private:
-    template<typename _Head, typename... _Tail>
-    void _count_types()
+    inline std::size_t get_system_count() const { return m_systems.size(); }
+
+    /**
+     * @brief Wave of every system for the current set of systems, systems in the same wave can
+     * run concurrently
+     */
+    std::vector<std::size_t> build_waves() const
     {
-        m_type_count++;
+        std::vector<std::size_t> waves(m_systems.size(), 0);
+        for (std::size_t i = 0; i < m_systems.size(); i++)
+        {
+            for (std::size_t j = 0; j < i; j++)
+            {
+                if (waves[j] >= waves[i] && m_systems[i].access.conflicts(m_systems[j].access))
+                    waves[i] = waves[j] + 1;
+            }
+        }
 
-        if constexpr (sizeof...(_Tail) > 0)
-            _count_types<_Tail...>();
+        return waves;
     }
 
-    template<typename _Head, typename... _Tail>
-    void fill_result(Entity entity, std::size_t target_index, std::size_t& valid_count)
+    void run() { run(ThreadPool::get_global()); }
+
+    /**
+     * @brief Runs every system once, see View::par_each() for what the executor has to provide
+     */
+    template<typename _Executor>
+    void run(_Executor& executor)
     {
-        ObjectPool* target_pool = m_registry->get_pool<_Head>();
-        if (target_pool != nullptr)
+        ECS_PROFILE_SCOPE("ecs::Scheduler::run");
+        const std::vector<std::size_t> waves = build_waves();
+        const std::size_t wave_count =
+            waves.empty() ? 0 : *std::max_element(waves.begin(), waves.end()) + 1;
+        std::vector<std::size_t> wave_systems = {};
+
+        const Registry::TypedPoolsLock lock = Registry::TypedPoolsLock(*m_registry);
+        for (std::size_t wave = 0; wave < wave_count; wave++)
         {
-            _Head* target_ptr = target_pool->get_entitys_object<_Head>(entity);
-            if (target_ptr != nullptr)
+            wave_systems.clear();
+            for (std::size_t i = 0; i < waves.size(); i++)
             {
-                std::get<_Head*>(m_reserved_from_valid) = target_ptr;
-                valid_count++;
-
-                if constexpr (sizeof...(_Tail) > 0)
-                    fill_result<_Tail...>(entity, target_index + 1, valid_count);
+                if (waves[i] == wave)
+                    wave_systems.push_back(i);
             }
+
+            executor.run(
+                wave_systems.size(),
+                [this, &wave_systems](std::size_t index)
+                {
+                    ECS_PROFILE_SCOPE("ecs::Scheduler::system");
+                    m_systems[wave_systems[index]].system(*m_registry);
+                }
+            );
         }
     }
 
+  private:
+    struct Entry
+    {
+        SystemAccess access = {};
+        System system = nullptr;
+    };
+
   private:
     Registry* m_registry = nullptr;
-    std::size_t m_type_count = 0;
-    std::tuple<_T*, _Ts*...> m_reserved_from_valid = {};
+    std::vector<Entry> m_systems = {};
 };
 
 } // namespace ecs
@@ -0,0 +1,317 @@
+/**
+ * @file benchmarks.cpp
+ * @copyright Copyright (c) 2023-present Ewan Robson.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+
+#include "../ecs.hpp"
+#include <benchmark/benchmark.h>
+
+struct Vector3
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+};
+
+struct Position
+{
+    Vector3 value = {};
+};
+
+struct Velocity
+{
+    Vector3 value = {1.0f, 2.0f, 3.0f};
+};
+
+struct Collider
+{
+    float radius = 1.0f;
+};
+
+/**
+ * @brief Every entity has a Position, and either every entity (dense) or every 10th entity
+ * (sparse) also has a Velocity and a Collider
+ */
+static void fill_registry(ecs::Registry& registry, std::size_t count, bool sparse)
+{
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(count);
+    registry.create_entities(entities);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        registry.create_component<Position>(entities[i]);
+        if (!sparse || i % 10 == 0)
+        {
+            registry.create_component<Velocity>(entities[i]);
+            registry.create_component<Collider>(entities[i]);
+        }
+    }
+}
+
+static void set_entity_counter(benchmark::State& state)
+{
+    state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+
+static void create_entity(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        ecs::Registry registry = ecs::Registry();
+        for (std::int64_t i = 0; i < state.range(0); i++)
+            benchmark::DoNotOptimize(registry.create_entity());
+    }
+
+    set_entity_counter(state);
+}
+
+static void create_component(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ecs::Registry* registry = new ecs::Registry();
+        std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(state.range(0));
+        registry->create_entities(entities);
+        state.ResumeTiming();
+
+        for (ecs::Entity entity : entities)
+            benchmark::DoNotOptimize(registry->create_component<Position>(entity));
+
+        state.PauseTiming();
+        delete registry;
+        state.ResumeTiming();
+    }
+
+    set_entity_counter(state);
+}
+
+static void create_components(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ecs::Registry* registry = new ecs::Registry();
+        std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(state.range(0));
+        registry->create_entities(entities);
+        state.ResumeTiming();
+
+        registry->create_components<Position>(entities, Position());
+
+        state.PauseTiming();
+        delete registry;
+        state.ResumeTiming();
+    }
+
+    set_entity_counter(state);
+}
+
+static void instantiate(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ecs::Registry* registry = new ecs::Registry();
+        ecs::Entity prefab = registry->create_entity();
+        registry->create_component<Position>(prefab);
+        registry->create_component<Velocity>(prefab);
+        registry->create_component<Collider>(prefab);
+        std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(state.range(0));
+        state.ResumeTiming();
+
+        registry->instantiate(prefab, entities);
+
+        state.PauseTiming();
+        delete registry;
+        state.ResumeTiming();
+    }
+
+    set_entity_counter(state);
+}
+
+/**
+ * @brief Random access through either the type lookup of Registry or the compile time index of
+ * StaticRegistry
+ */
+template<typename _Registry>
+static void get_component(benchmark::State& state)
+{
+    _Registry registry = _Registry();
+    fill_registry(registry, state.range(0), false);
+
+    for (auto _ : state)
+    {
+        for (ecs::Entity entity : registry.get_entities())
+            benchmark::DoNotOptimize(registry.template get_component<Velocity>(entity));
+    }
+
+    set_entity_counter(state);
+}
+
+static void destroy_entity(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        state.PauseTiming();
+        ecs::Registry* registry = new ecs::Registry();
+        fill_registry(*registry, state.range(0), false);
+        std::vector<ecs::Entity> entities = registry->get_entities();
+        state.ResumeTiming();
+
+        for (ecs::Entity entity : entities)
+            registry->destroy_entity(entity);
+
+        state.PauseTiming();
+        delete registry;
+        state.ResumeTiming();
+    }
+
+    set_entity_counter(state);
+}
+
+template<bool _Sparse, typename... _Ts>
+static void view_iteration(benchmark::State& state)
+{
+    ecs::Registry registry = ecs::Registry();
+    fill_registry(registry, state.range(0), _Sparse);
+
+    auto view = ecs::View<_Ts...>(&registry);
+    for (auto _ : state)
+    {
+        for (auto components : view)
+            benchmark::DoNotOptimize(components);
+    }
+
+    set_entity_counter(state);
+}
+
+/**
+ * @brief Integrates Position by Velocity through either the per entity iterator or the spans of
+ * View::chunks() over packed pools
+ */
+template<bool _Chunks>
+static void view_integrate(benchmark::State& state)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<Position>(ecs::ObjectPoolLayout::Packed, 1024, ECS_SIMD_ALIGNMENT);
+    registry.create_pool<Velocity>(ecs::ObjectPoolLayout::Packed, 1024, ECS_SIMD_ALIGNMENT);
+    fill_registry(registry, state.range(0), false);
+
+    auto view = ecs::View<Position, const Velocity>(&registry);
+    for (auto _ : state)
+    {
+        if constexpr (_Chunks)
+        {
+            for (auto [entities, positions, velocities] : view.chunks())
+            {
+                float* position_data = reinterpret_cast<float*>(positions.data());
+                const float* velocity_data = reinterpret_cast<const float*>(velocities.data());
+                for (std::size_t i = 0; i < positions.size() * 3; i++)
+                    position_data[i] += velocity_data[i];
+            }
+        }
+        else
+        {
+            for (auto [entity, position, velocity] : view)
+            {
+                position->value.x += velocity->value.x;
+                position->value.y += velocity->value.y;
+                position->value.z += velocity->value.z;
+            }
+        }
+
+        benchmark::ClobberMemory();
+    }
+
+    set_entity_counter(state);
+}
+
+/**
+ * @brief Same integration as view_integrate over an owning group of the two packed pools. Every
+ * third entity has no Velocity so the view can't walk the pools in lockstep
+ */
+template<bool _Group>
+static void sparse_integrate(benchmark::State& state)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<Position>(ecs::ObjectPoolLayout::Packed, 1024);
+    registry.create_pool<Velocity>(ecs::ObjectPoolLayout::Packed, 1024);
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(state.range(0));
+    registry.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        registry.create_component<Position>(entities[i]);
+        if (i % 3 != 0)
+            registry.create_component<Velocity>(entities[i]);
+    }
+
+    auto integrate = [](ecs::Entity, Position* position, const Velocity* velocity)
+    {
+        position->value.x += velocity->value.x;
+        position->value.y += velocity->value.y;
+        position->value.z += velocity->value.z;
+    };
+
+    if constexpr (_Group)
+    {
+        auto group = registry.group<Position, const Velocity>();
+        for (auto _ : state)
+        {
+            group.each(integrate);
+            benchmark::ClobberMemory();
+        }
+    }
+    else
+    {
+        auto view = ecs::View<Position, const Velocity>(&registry);
+        for (auto _ : state)
+        {
+            view.each(integrate);
+            benchmark::ClobberMemory();
+        }
+    }
+
+    set_entity_counter(state);
+}
+
+#define ECS_BENCHMARK_SIZES ->Arg(1000)->Arg(100000)->Arg(1000000)->Unit(benchmark::kMicrosecond)
+
+BENCHMARK(create_entity) ECS_BENCHMARK_SIZES;
+BENCHMARK(create_component) ECS_BENCHMARK_SIZES;
+BENCHMARK(create_components) ECS_BENCHMARK_SIZES;
+BENCHMARK(instantiate) ECS_BENCHMARK_SIZES;
+BENCHMARK(get_component<ecs::Registry>) ECS_BENCHMARK_SIZES;
+BENCHMARK(get_component<ecs::StaticRegistry<Position, Velocity, Collider>>) ECS_BENCHMARK_SIZES;
+BENCHMARK(destroy_entity) ECS_BENCHMARK_SIZES;
+
+BENCHMARK(view_iteration<false, Position>) ECS_BENCHMARK_SIZES;
+BENCHMARK(view_iteration<false, Position, Velocity>) ECS_BENCHMARK_SIZES;
+BENCHMARK(view_iteration<false, Position, Velocity, Collider>) ECS_BENCHMARK_SIZES;
+BENCHMARK(view_iteration<true, Position, Velocity>) ECS_BENCHMARK_SIZES;
+BENCHMARK(view_iteration<true, Position, Velocity, Collider>) ECS_BENCHMARK_SIZES;
+
+BENCHMARK(view_integrate<false>) ECS_BENCHMARK_SIZES;
+BENCHMARK(view_integrate<true>) ECS_BENCHMARK_SIZES;
+BENCHMARK(sparse_integrate<false>) ECS_BENCHMARK_SIZES;
+BENCHMARK(sparse_integrate<true>) ECS_BENCHMARK_SIZES;
+
+BENCHMARK_MAIN();
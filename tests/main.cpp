@@ -21,8 +21,18 @@
  * SOFTWARE.
  */
 
+#include <atomic>
+
+static std::atomic<int> profile_scope_count = 0;
+
+#define ECS_ENABLE_STATS
+#define ECS_PROFILE_SCOPE(NAME) profile_scope_count++
+
 #include "../ecs.hpp"
+#include <fstream>
 #include <gtest/gtest.h>
+#include <sstream>
+#include <stdexcept>
 
 struct Vector3
 {
@@ -33,6 +43,7 @@ struct Vector3
     Vector3() = default;
     Vector3(float x, float y, float z) : x(x), y(y), z(z) {}
     Vector3(const Vector3& other) : x(other.x), y(other.y), z(other.z) {}
+    Vector3& operator=(const Vector3& other) = default;
 
     bool operator==(const Vector3& other) { return x == other.x && y == other.y && z == other.z; }
     bool operator!=(const Vector3& other) { return !(*this == other); }
@@ -71,6 +82,35 @@ TEST(Registry, create_entity)
     SUCCEED();
 }
 
+TEST(Registry, generational_entities)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity first = registry.create_entity();
+    ecs::Entity second = registry.create_entity();
+    registry.create_component<NameComponent>(first, "first");
+
+    registry.destroy_entity(first);
+    EXPECT_FALSE(registry.valid(first));
+    EXPECT_TRUE(registry.valid(second));
+
+    ecs::Entity reused = registry.create_entity();
+    EXPECT_EQ(reused.get_index(), first.get_index());
+    EXPECT_EQ(reused.get_generation(), first.get_generation() + 1);
+    EXPECT_TRUE(reused != first);
+    EXPECT_TRUE(registry.valid(reused));
+    EXPECT_FALSE(registry.valid(first));
+
+    registry.create_component<NameComponent>(reused, "reused");
+    EXPECT_TRUE(registry.get_component<NameComponent>(first) == nullptr);
+    EXPECT_EQ(registry.get_component<NameComponent>(reused)->name, "reused");
+
+    registry.destroy_entity(second);
+    registry.destroy_entity(reused);
+    EXPECT_EQ(registry.create_entity().get_index(), reused.get_index());
+    EXPECT_EQ(registry.create_entity().get_index(), second.get_index());
+    EXPECT_EQ(registry.create_entity().get_index(), 2);
+}
+
 TEST(Registry, get_target_pool)
 {
     ecs::Registry registry = ecs::Registry();
@@ -100,9 +140,12 @@ TEST(Registry, destroy_entity)
     for (std::size_t i = 0; i < entities.size(); i++)
     {
         if (i == 7)
-            EXPECT_EQ(static_cast<std::size_t>(entities[i]), std::string::npos);
+            EXPECT_FALSE(registry.valid(ecs::Entity{i}));
         else
+        {
+            EXPECT_TRUE(registry.valid(ecs::Entity{i}));
             EXPECT_EQ(static_cast<std::size_t>(entities[i]), i);
+        }
     }
 }
 
@@ -128,14 +171,16 @@ TEST(Registry, destroy_entity_with_components)
     for (std::size_t i = 0; i < entities.size(); i++)
     {
         if (i == 7)
-            EXPECT_EQ(static_cast<std::size_t>(entities[i]), std::string::npos);
+            EXPECT_FALSE(registry.valid(ecs::Entity{i}));
         else
+        {
+            EXPECT_TRUE(registry.valid(ecs::Entity{i}));
             EXPECT_EQ(static_cast<std::size_t>(entities[i]), i);
+        }
     }
 
     ecs::ObjectPool* pool = registry.get_pool<TransformComponent>();
-    ecs::byte* byte_data = pool->get_blocks().front() +
-                           (sizeof(ecs::ObjectPoolChunk) + sizeof(TransformComponent)) * 7;
+    ecs::byte* byte_data = pool->get_blocks().front() + pool->get_chunk_stride() * 7;
     ecs::ObjectPoolChunk* chunk = reinterpret_cast<ecs::ObjectPoolChunk*>(byte_data);
 
     EXPECT_TRUE(chunk->entity == ECS_ENTITY_DESTROYED);
@@ -161,14 +206,16 @@ TEST(Registry, destroy_entity_with_components_and_deconstructor)
     for (std::size_t i = 0; i < entities.size(); i++)
     {
         if (i == 7)
-            EXPECT_EQ(static_cast<std::size_t>(entities[i]), std::string::npos);
+            EXPECT_FALSE(registry.valid(ecs::Entity{i}));
         else
+        {
+            EXPECT_TRUE(registry.valid(ecs::Entity{i}));
             EXPECT_EQ(static_cast<std::size_t>(entities[i]), i);
+        }
     }
 
     ecs::ObjectPool* pool = registry.get_pool<NameComponent>();
-    ecs::byte* byte_data =
-        pool->get_blocks().front() + (sizeof(ecs::ObjectPoolChunk) + sizeof(NameComponent)) * 7;
+    ecs::byte* byte_data = pool->get_blocks().front() + pool->get_chunk_stride() * 7;
     ecs::ObjectPoolChunk* chunk = reinterpret_cast<ecs::ObjectPoolChunk*>(byte_data);
 
     EXPECT_TRUE(chunk->entity == ECS_ENTITY_DESTROYED);
@@ -188,6 +235,567 @@ TEST(Registry, create_1_component)
     SUCCEED();
 }
 
+TEST(Registry, get_component_across_blocks)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = {};
+
+    for (std::size_t i = 0; i < ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE * 4; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity, Vector3(i, i, i));
+        entities.push_back(entity);
+    }
+
+    for (std::size_t i = 0; i < entities.size(); i += 3)
+        registry.destroy_entity(entities[i]);
+
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        TransformComponent* transform = registry.get_component<TransformComponent>(entities[i]);
+        if (i % 3 == 0)
+            EXPECT_TRUE(transform == nullptr);
+        else
+        {
+            EXPECT_TRUE(transform != nullptr);
+            EXPECT_TRUE(transform->position == Vector3(i, i, i));
+        }
+    }
+
+    ecs::ObjectPool* pool = registry.get_pool<TransformComponent>();
+    EXPECT_EQ(pool->get_count(), entities.size() - (entities.size() + 2) / 3);
+}
+
+TEST(Registry, packed_pool_swap_and_pop)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::ObjectPool* pool = registry.create_pool<NameComponent>(ecs::ObjectPoolLayout::Packed, 4);
+    std::vector<ecs::Entity> entities = {};
+
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<NameComponent>(entity, "entity_" + std::to_string(i));
+        entities.push_back(entity);
+    }
+
+    registry.destroy_entity(entities[2]);
+    registry.destroy_entity(entities[5]);
+
+    EXPECT_EQ(pool->get_count(), 8);
+    EXPECT_TRUE(registry.get_component<NameComponent>(entities[2]) == nullptr);
+    EXPECT_TRUE(registry.get_component<NameComponent>(entities[9]) != nullptr);
+    EXPECT_EQ(registry.get_component<NameComponent>(entities[9])->name, "entity_9");
+
+    const std::pmr::vector<ecs::Entity>& dense = pool->get_dense_entities();
+    NameComponent* names = pool->data<NameComponent>();
+    for (std::size_t i = 0; i < pool->get_count(); i++)
+        EXPECT_EQ(names[i].name, "entity_" + std::to_string(dense[i].id));
+}
+
+TEST(Registry, get_pool_by_hash)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity entity = registry.create_entity();
+
+    std::byte* data = registry.create_component(
+        entity, ecs::type_descriptor::get_hash<Vector3>(), "Vector3", sizeof(Vector3),
+        [](std::byte* target) { reinterpret_cast<Vector3*>(target)->~Vector3(); },
+        [](std::byte* target) { new (reinterpret_cast<Vector3*>(target)) Vector3(1, 2, 3); }
+    );
+
+    EXPECT_TRUE(data != nullptr);
+    EXPECT_TRUE(registry.get_pool(ecs::type_descriptor::get_hash<Vector3>()) != nullptr);
+    EXPECT_TRUE(registry.get_component<Vector3>(entity) == reinterpret_cast<Vector3*>(data));
+    EXPECT_TRUE(*registry.get_component<Vector3>(entity) == Vector3(1, 2, 3));
+
+    std::vector<ecs::ObjectPool*> pools = {};
+    ecs::ObjectPoolMap map = ecs::ObjectPoolMap();
+    for (std::uint64_t i = 0; i < 100; i++)
+    {
+        pools.push_back(new ecs::ObjectPool("pool_" + std::to_string(i), 4, i * 31, 1));
+        map.insert(pools.back());
+    }
+
+    EXPECT_EQ(map.size(), 100);
+    for (std::uint64_t i = 0; i < 100; i++)
+        EXPECT_TRUE(map.find(i * 31) == pools[i]);
+    EXPECT_TRUE(map.find(1) == nullptr);
+
+    for (ecs::ObjectPool* pool : pools)
+        delete pool;
+}
+
+TEST(Registry, copy_components)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity source = registry.create_entity();
+    std::vector<ecs::Entity> copies = std::vector<ecs::Entity>(40);
+    registry.create_entities(copies);
+
+    registry.create_pool<NameComponent>(ecs::ObjectPoolLayout::Packed, 4);
+    ecs::ObjectPool* names = registry.get_pool<NameComponent>();
+    NameComponent* prototype = registry.create_component<NameComponent>(source, "prototype");
+    EXPECT_TRUE(names->is_copyable());
+    EXPECT_FALSE(names->is_trivially_relocatable());
+
+    names->copy(copies, reinterpret_cast<std::byte*>(prototype));
+    for (ecs::Entity entity : copies)
+        EXPECT_EQ(registry.get_component<NameComponent>(entity)->name, "prototype");
+
+    struct Point
+    {
+        int x = 0;
+        int y = 0;
+    };
+
+    registry.create_component<Point>(source, Point{1, 2});
+    ecs::ObjectPool* points = registry.get_pool<Point>();
+    EXPECT_TRUE(points->is_trivially_relocatable());
+    EXPECT_TRUE(points->is_trivially_copyable());
+
+    registry.create_component(
+        source, 7, "RuntimeVector3", sizeof(Vector3), nullptr,
+        [](std::byte* target) { new (reinterpret_cast<Vector3*>(target)) Vector3(1, 2, 3); }
+    );
+    ecs::ObjectPool* runtime = registry.get_pool(7);
+    EXPECT_FALSE(runtime->is_copyable());
+
+    runtime->set_copy_constructor(
+        [](std::byte* target, const std::byte* source)
+        {
+            const Vector3* source_vector = reinterpret_cast<const Vector3*>(source);
+            new (reinterpret_cast<Vector3*>(target)) Vector3(*source_vector);
+        }
+    );
+    runtime->copy(copies[0], runtime->get_entitys_object(source));
+
+    Vector3* copy = reinterpret_cast<Vector3*>(registry.get_component(copies[0], 7));
+    EXPECT_TRUE(*copy == Vector3(1, 2, 3));
+}
+
+TEST(Registry, instantiate)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<TransformComponent>(ecs::ObjectPoolLayout::Packed);
+
+    ecs::Entity prefab = registry.create_entity();
+    registry.create_component<TransformComponent>(prefab, Vector3(1, 2, 3));
+    registry.create_component<NameComponent>(prefab, "prefab");
+
+    std::vector<ecs::Entity> entities = registry.instantiate(prefab, 100);
+    EXPECT_EQ(registry.get_pool<TransformComponent>()->get_count(), 101);
+    EXPECT_EQ(registry.get_pool<NameComponent>()->get_count(), 101);
+
+    for (ecs::Entity entity : entities)
+    {
+        EXPECT_TRUE(registry.valid(entity));
+        EXPECT_TRUE(registry.get_component<TransformComponent>(entity)->position == Vector3(1, 2, 3));
+        EXPECT_EQ(registry.get_component<NameComponent>(entity)->name, "prefab");
+    }
+
+    ecs::Registry other = ecs::Registry();
+    std::vector<ecs::Entity> others = std::vector<ecs::Entity>(10);
+    other.instantiate(registry, prefab, others);
+
+    EXPECT_EQ(other.get_pools().size(), 2);
+    EXPECT_EQ(other.get_pool<TransformComponent>()->get_layout(), ecs::ObjectPoolLayout::Packed);
+    for (ecs::Entity entity : others)
+        EXPECT_EQ(other.get_component<NameComponent>(entity)->name, "prefab");
+}
+
+TEST(Registry, create_entities_and_components)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity first = registry.create_entity();
+    registry.create_entity();
+    registry.destroy_entity(first);
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(100);
+    registry.create_entities(entities);
+    EXPECT_TRUE(entities[0] == ecs::Entity::create(first.get_index(), 1));
+    EXPECT_TRUE(entities[1] == ecs::Entity{2});
+    EXPECT_TRUE(entities[99] == ecs::Entity{100});
+
+    ecs::ObjectPool* pool = registry.reserve<TransformComponent>(100);
+    std::size_t block_count = pool->get_blocks().size();
+    EXPECT_TRUE(pool->get_capacity() >= 100);
+
+    registry.create_components<TransformComponent>(
+        entities, TransformComponent(Vector3(1.0f, 2.0f, 3.0f))
+    );
+    EXPECT_EQ(pool->get_count(), 100);
+    EXPECT_EQ(pool->get_blocks().size(), block_count);
+
+    for (ecs::Entity entity : entities)
+    {
+        TransformComponent* transform = registry.get_component<TransformComponent>(entity);
+        EXPECT_TRUE(transform != nullptr);
+        EXPECT_TRUE(transform->position == Vector3(1.0f, 2.0f, 3.0f));
+    }
+
+    registry.create_pool<NameComponent>(ecs::ObjectPoolLayout::Packed);
+    registry.create_components<NameComponent>(entities, NameComponent("entity"));
+    EXPECT_EQ(registry.get_pool<NameComponent>()->get_count(), 100);
+    EXPECT_EQ(registry.get_component<NameComponent>(entities[50])->name, "entity");
+}
+
+#ifndef NDEBUG
+TEST(Registry, type_contradiction)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity entity = registry.create_entity();
+    ecs::ObjectPool* pool = registry.create_pool<TransformComponent>(ecs::ObjectPoolLayout::Chunked);
+
+    EXPECT_EXIT(pool->malloc<Vector3>(entity), testing::ExitedWithCode(255), "");
+}
+#endif
+
+TEST(Registry, memory_resource)
+{
+    std::pmr::monotonic_buffer_resource arena = std::pmr::monotonic_buffer_resource();
+    {
+        ecs::Registry registry = ecs::Registry(&arena);
+        registry.create_pool<NameComponent>(ecs::ObjectPoolLayout::Packed);
+        for (std::size_t i = 0; i < 100; i++)
+        {
+            ecs::Entity entity = registry.create_entity();
+            registry.create_component<TransformComponent>(entity, Vector3(i, i, i));
+            registry.create_component<NameComponent>(entity, "entity");
+        }
+
+        EXPECT_TRUE(registry.get_pool<TransformComponent>()->get_resource() == &arena);
+        EXPECT_TRUE(registry.get_pool<NameComponent>()->get_resource() == &arena);
+        EXPECT_TRUE(registry.get_component<TransformComponent>(ecs::Entity{42})->position ==
+                    Vector3(42, 42, 42));
+    }
+
+#if defined(__linux__)
+    ecs::HugePageResource huge_pages = ecs::HugePageResource(&arena, 0);
+    ecs::Registry registry = ecs::Registry(&huge_pages);
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(100000);
+    registry.create_entities(entities);
+    registry.reserve<TransformComponent>(entities.size());
+    registry.create_components<TransformComponent>(entities, TransformComponent());
+    EXPECT_EQ(registry.get_pool<TransformComponent>()->get_count(), entities.size());
+#endif
+}
+
+struct alignas(32) AlignedVector
+{
+    float x = 0;
+    float y = 0;
+    float z = 0;
+};
+
+TEST(Registry, component_alignment)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<Vector3>(ecs::ObjectPoolLayout::Packed, 4, ECS_SIMD_ALIGNMENT);
+
+    for (std::size_t i = 0; i < 100; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        AlignedVector* aligned = registry.create_component<AlignedVector>(entity);
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(aligned) % alignof(AlignedVector), 0);
+
+        TransformComponent* transform = registry.create_component<TransformComponent>(entity);
+        ecs::ObjectPoolChunk* chunk = reinterpret_cast<ecs::ObjectPoolChunk*>(
+            reinterpret_cast<std::byte*>(transform) -
+            registry.get_pool<TransformComponent>()->get_chunk_offset()
+        );
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(chunk) % alignof(ecs::ObjectPoolChunk), 0);
+
+        registry.create_component<Vector3>(entity);
+        ecs::ObjectPool* pool = registry.get_pool<Vector3>();
+        EXPECT_EQ(reinterpret_cast<std::uintptr_t>(pool->data()) % ECS_SIMD_ALIGNMENT, 0);
+        EXPECT_EQ(pool->get_padded_count() * sizeof(Vector3) % ECS_SIMD_ALIGNMENT, 0);
+        EXPECT_TRUE(pool->get_padded_count() <= pool->get_capacity());
+    }
+}
+
+TEST(Registry, stats)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    registry.create_entities(entities);
+    registry.create_components<TransformComponent>(entities, TransformComponent());
+    registry.destroy_entity(entities[2]);
+    registry.destroy_entity(entities[5]);
+
+    ecs::ObjectPoolStats pool = registry.get_pool<TransformComponent>()->get_stats();
+    EXPECT_EQ(pool.count, 8);
+    EXPECT_EQ(pool.free_count, 2);
+    EXPECT_EQ(pool.capacity, ECS_REGISTRY_DEFAULT_POOL_BLOCK_SIZE);
+    EXPECT_EQ(pool.block_count, 1);
+    EXPECT_EQ(pool.used_bytes, 8 * sizeof(TransformComponent));
+    EXPECT_GE(pool.reserved_bytes, pool.capacity * sizeof(TransformComponent));
+    EXPECT_DOUBLE_EQ(pool.fragmentation, 0.2);
+
+    registry.reset_stats();
+    registry.get_component<TransformComponent>(entities[0]);
+    ecs::View<TransformComponent>(&registry).each([](ecs::Entity, TransformComponent*) {});
+
+    ecs::RegistryStats stats = registry.get_stats();
+    EXPECT_EQ(stats.entity_count, 8);
+    EXPECT_EQ(stats.free_entity_count, 2);
+    EXPECT_EQ(stats.pool_count, 1);
+    EXPECT_EQ(stats.pools.count, 8);
+    EXPECT_EQ(stats.pools.lookups, 1);
+    EXPECT_EQ(stats.pools.iterations, 8);
+}
+
+TEST(Registry, compact)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(100);
+    registry.create_entities(entities);
+    for (ecs::Entity entity : entities)
+        registry.create_component<NameComponent>(entity, std::to_string(entity.get_index()));
+
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        if (i % 3 != 0)
+            registry.destroy_entity(entities[i]);
+    }
+
+    ecs::ObjectPool* pool = registry.get_pool<NameComponent>();
+    EXPECT_EQ(pool->get_blocks().size(), 4);
+
+    registry.compact();
+    EXPECT_EQ(pool->get_blocks().size(), 2);
+    EXPECT_EQ(pool->get_free_locations().size(), 0);
+
+    for (std::size_t i = 0; i < entities.size(); i += 3)
+    {
+        NameComponent* name = registry.get_component<NameComponent>(entities[i]);
+        ASSERT_NE(name, nullptr);
+        EXPECT_EQ(name->name, std::to_string(i));
+    }
+
+    for (std::size_t i = 1; i < pool->get_count(); i++)
+    {
+        EXPECT_LT(
+            pool->get_dense_entities()[i - 1].get_index(), pool->get_dense_entities()[i].get_index()
+        );
+        EXPECT_EQ(
+            reinterpret_cast<std::byte*>(pool->get_dense_chunks()[i]) -
+                reinterpret_cast<std::byte*>(pool->get_dense_chunks()[i - 1]),
+            pool->get_chunk_stride()
+        );
+    }
+
+    ecs::Entity created = registry.create_entity();
+    registry.create_component<NameComponent>(created, "created");
+    EXPECT_EQ(registry.get_component<NameComponent>(created)->name, "created");
+}
+
+TEST(Registry, compact_incremental)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(90);
+    registry.create_entities(entities);
+    for (ecs::Entity entity : entities)
+        registry.create_component<NameComponent>(entity, std::to_string(entity.get_index()));
+
+    // Free most of the first two blocks so the third one fits into their holes
+    for (std::size_t i = 0; i < 60; i++)
+    {
+        if (i % 4 != 0)
+            registry.destroy_entity(entities[i]);
+    }
+
+    ecs::ObjectPool* pool = registry.get_pool<NameComponent>();
+    EXPECT_FALSE(pool->compact(std::chrono::nanoseconds(0)));
+    EXPECT_EQ(pool->get_blocks().size(), 3);
+
+    while (!registry.compact(std::chrono::microseconds(10)))
+        ;
+
+    EXPECT_EQ(pool->get_blocks().size(), 2);
+    EXPECT_EQ(pool->get_count(), 45);
+    EXPECT_EQ(pool->get_free_locations().size(), 60 - 45);
+
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        if (i >= 60 || i % 4 == 0)
+        {
+            EXPECT_EQ(registry.get_component<NameComponent>(entities[i])->name, std::to_string(i));
+        }
+    }
+
+    pool->compact(std::chrono::seconds(1));
+    EXPECT_EQ(pool->get_blocks().size(), 2);
+}
+
+TEST(Registry, serialize)
+{
+    struct Health
+    {
+        int value = 0;
+    };
+
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<Health>(ecs::ObjectPoolLayout::Packed, 8, ECS_SIMD_ALIGNMENT);
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(20);
+    registry.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        registry.create_component<Health>(entities[i], Health{static_cast<int>(i)});
+        if (i % 2 == 0)
+            registry.create_component<ecs::Entity>(entities[i], entities[i]);
+        registry.create_component<NameComponent>(entities[i], "skipped");
+    }
+    registry.destroy_entity(entities[3]);
+
+    std::stringstream stream = std::stringstream();
+    registry.serialize(stream);
+
+    auto check = [&entities](ecs::Registry& loaded)
+    {
+        EXPECT_EQ(loaded.get_entities().size(), 20);
+        EXPECT_FALSE(loaded.valid(entities[3]));
+        EXPECT_TRUE(loaded.get_pool<NameComponent>() == nullptr);
+        EXPECT_EQ(loaded.get_pool<Health>()->get_count(), 19);
+        EXPECT_EQ(loaded.get_pool<ecs::Entity>()->get_count(), 10);
+
+        for (std::size_t i = 0; i < entities.size(); i++)
+        {
+            if (i == 3)
+                continue;
+
+            EXPECT_TRUE(loaded.valid(entities[i]));
+            EXPECT_EQ(loaded.get_component<Health>(entities[i])->value, static_cast<int>(i));
+            if (i % 2 == 0)
+            {
+                EXPECT_TRUE(*loaded.get_component<ecs::Entity>(entities[i]) == entities[i]);
+            }
+        }
+
+        ecs::Entity created = loaded.create_entity();
+        EXPECT_EQ(created.get_index(), 3);
+        loaded.create_component<Health>(created, Health{42});
+        EXPECT_EQ(loaded.get_component<Health>(created)->value, 42);
+    };
+
+    ecs::Registry loaded = ecs::Registry();
+    EXPECT_TRUE(loaded.deserialize(stream));
+    check(loaded);
+
+#if defined(__linux__)
+    const std::string path = testing::TempDir() + "ecs_snapshot.bin";
+    {
+        std::ofstream file = std::ofstream(path, std::ios::binary);
+        registry.serialize(file);
+    }
+
+    ecs::Registry mapped = ecs::Registry();
+    EXPECT_TRUE(mapped.load_mapped(path));
+    std::remove(path.c_str());
+
+    const std::byte* data = mapped.get_pool<Health>()->data();
+    EXPECT_EQ(reinterpret_cast<std::uintptr_t>(data) % ECS_SIMD_ALIGNMENT, 0);
+    check(mapped);
+
+    // Growing past the adopted pages moves the objects into memory of the pool
+    std::vector<ecs::Entity> more = std::vector<ecs::Entity>(40);
+    mapped.create_entities(more);
+    mapped.create_components<Health>(more, Health{7});
+    EXPECT_NE(mapped.get_pool<Health>()->data(), data);
+    EXPECT_EQ(mapped.get_component<Health>(entities[19])->value, 19);
+#endif
+
+    std::stringstream garbage = std::stringstream("not a snapshot");
+    ecs::Registry invalid = ecs::Registry();
+    EXPECT_FALSE(invalid.deserialize(garbage));
+}
+
+TEST(Registry, deserialize_corrupt)
+{
+    struct Health
+    {
+        int value = 0;
+    };
+
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(8);
+    registry.create_entities(entities);
+    registry.create_components<Health>(entities, Health{5});
+
+    std::stringstream stream = std::stringstream();
+    registry.serialize(stream);
+    const std::string snapshot = stream.str();
+    const std::size_t pool_offset = sizeof(ecs::SnapshotHeader) + sizeof(ecs::Entity) * 8;
+
+    auto load = [](const std::string& bytes)
+    {
+        std::stringstream input = std::stringstream(bytes);
+        ecs::Registry loaded = ecs::Registry();
+        const bool result = loaded.deserialize(input);
+
+#if defined(__linux__)
+        const std::string path = testing::TempDir() + "ecs_corrupt_snapshot.bin";
+        {
+            std::ofstream file = std::ofstream(path, std::ios::binary);
+            file.write(bytes.data(), static_cast<std::streamsize>(bytes.size()));
+        }
+
+        ecs::Registry mapped = ecs::Registry();
+        EXPECT_EQ(mapped.load_mapped(path), result);
+        std::remove(path.c_str());
+#endif
+
+        return result;
+    };
+
+    EXPECT_TRUE(load(snapshot));
+    for (std::size_t size = 0; size < snapshot.size(); size++)
+        EXPECT_FALSE(load(snapshot.substr(0, size)));
+
+    auto modify_header = [&snapshot](auto modify)
+    {
+        std::string bytes = snapshot;
+        ecs::SnapshotHeader header = {};
+        std::memcpy(&header, bytes.data(), sizeof(header));
+        modify(header);
+        std::memcpy(bytes.data(), &header, sizeof(header));
+        return bytes;
+    };
+
+    EXPECT_FALSE(load(modify_header([](ecs::SnapshotHeader& header)
+                                    { header.entity_count = 1ull << 61; })));
+    EXPECT_FALSE(load(modify_header([](ecs::SnapshotHeader& header) { header.free_head = 8; })));
+
+    auto modify_pool = [&snapshot, pool_offset](auto modify)
+    {
+        std::string bytes = snapshot;
+        ecs::SnapshotPoolHeader header = {};
+        std::memcpy(&header, bytes.data() + pool_offset, sizeof(header));
+        modify(header);
+        std::memcpy(bytes.data() + pool_offset, &header, sizeof(header));
+        return bytes;
+    };
+
+    using Header = ecs::SnapshotPoolHeader;
+    EXPECT_TRUE(load(modify_pool([](Header&) {})));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.count = 1ull << 61; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.type_size = 1ull << 62; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.payload_size = 1ull << 62; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.alignment = 0; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.alignment = 12; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.layout = 7; })));
+    EXPECT_FALSE(load(modify_pool([](Header& header) { header.block_size = 0; })));
+
+    // Pool entities have to be alive in the snapshot
+    std::string bytes = snapshot;
+    const ecs::Entity unknown = ecs::Entity::create(1000, 0);
+    const std::size_t name_size = ecs::type_descriptor::get_name<Health>().size();
+    const std::size_t entities_offset = (pool_offset + sizeof(Header) + name_size + 7) / 8 * 8;
+    std::memcpy(bytes.data() + entities_offset, &unknown, sizeof(ecs::Entity));
+    EXPECT_FALSE(load(bytes));
+}
+
 TEST(View, has_required_for_1_component)
 {
     ecs::Registry registry = ecs::Registry();
@@ -199,10 +807,11 @@ TEST(View, has_required_for_1_component)
 
     auto view = ecs::View<TransformComponent>(&registry);
     std::size_t count = 0;
-    for (ecs::Entity entity : view)
+    for (auto [entity, transform] : view)
     {
         bool result = view.has_required(entity);
         EXPECT_TRUE(result);
+        EXPECT_TRUE(transform == view.get<TransformComponent>());
         if (result)
             count++;
     }
@@ -226,25 +835,1285 @@ TEST(View, has_required_for_multiple_components)
     }
 
     auto view = ecs::View<TransformComponent, NameComponent>(&registry);
-    std::size_t i = 0;
-    std::size_t count = 0;
-    for (ecs::Entity entity : view)
+    for (std::size_t i = 0; i < registry.get_entities().size(); i++)
     {
-        bool result = view.has_required(entity);
+        bool result = view.has_required(registry.get_entities()[i]);
         if (i > 5)
-        {
             EXPECT_TRUE(result);
-            count++;
-        }
         else
             EXPECT_FALSE(result);
+    }
 
-        i++;
+    std::size_t count = 0;
+    for (auto [entity, transform, name] : view)
+    {
+        EXPECT_TRUE(entity.id > 5);
+        EXPECT_TRUE(transform->position == Vector3(entity.id, entity.id, entity.id));
+        EXPECT_EQ(name->name, "Entity" + std::to_string(entity.id));
+        count++;
     }
 
     EXPECT_EQ(count, 4);
 }
 
+TEST(View, skips_destroyed_entities)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = {};
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity, Vector3(i, i, i));
+        entities.push_back(entity);
+    }
+
+    registry.destroy_entity(entities[3]);
+    registry.destroy_entity(entities[4]);
+
+    std::size_t count = 0;
+    for (auto [entity, transform] : ecs::View<TransformComponent>(&registry))
+    {
+        EXPECT_TRUE(entity != entities[3] && entity != entities[4]);
+        count++;
+    }
+
+    EXPECT_EQ(count, 8);
+    EXPECT_TRUE(
+        ecs::View<NameComponent>(&registry).begin() == ecs::View<NameComponent>(&registry).end()
+    );
+}
+
+TEST(View, created_before_pools)
+{
+    ecs::Registry registry = ecs::Registry();
+    auto view = ecs::View<TransformComponent, NameComponent>(&registry);
+    EXPECT_TRUE(view.begin() == view.end());
+
+    ecs::Entity entity = registry.create_entity();
+    registry.create_component<TransformComponent>(entity, Vector3(1.0f, 2.0f, 3.0f));
+    registry.create_component<NameComponent>(entity, "entity");
+
+    std::size_t count = 0;
+    for (auto [target, transform, name] : view)
+    {
+        EXPECT_TRUE(target == entity);
+        EXPECT_TRUE(transform->position == Vector3(1.0f, 2.0f, 3.0f));
+        EXPECT_EQ(name->name, "entity");
+        count++;
+    }
+
+    EXPECT_EQ(count, 1);
+    EXPECT_TRUE(view.has_required(entity));
+    EXPECT_EQ(view.get<NameComponent>()->name, "entity");
+}
+
+TEST(View, each)
+{
+    ecs::Registry registry = ecs::Registry();
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity, Vector3(i, i, i));
+    }
+
+    float sum = 0.0f;
+    ecs::View<TransformComponent>(&registry).each(
+        [&sum](ecs::Entity, TransformComponent* transform) { sum += transform->position.x; }
+    );
+
+    EXPECT_EQ(sum, 45.0f);
+}
+
+struct SerialExecutor
+{
+    std::size_t batches = 0;
+
+    void run(std::size_t count, const std::function<void(std::size_t)>& job)
+    {
+        batches += count;
+        for (std::size_t i = 0; i < count; i++)
+            job(i);
+    }
+};
+
+TEST(View, par_each)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<TransformComponent>(ecs::ObjectPoolLayout::Packed);
+    for (std::size_t i = 0; i < 10000; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity, Vector3(i, 0, 0));
+        if (i % 2 == 0)
+            registry.create_component<NameComponent>(entity, "entity");
+    }
+
+    auto integrate = [](ecs::Entity, TransformComponent* transform, NameComponent*)
+    { transform->position.y = transform->position.x * 2.0f; };
+
+    ecs::ThreadPool pool = ecs::ThreadPool(3);
+    auto view = ecs::View<TransformComponent, NameComponent>(&registry);
+    view.par_each(integrate, pool, 64);
+
+    std::atomic<std::size_t> count = 0;
+    view.par_each(
+        [&count](ecs::Entity, TransformComponent* transform, NameComponent*)
+        {
+            EXPECT_EQ(transform->position.y, transform->position.x * 2.0f);
+            count++;
+        },
+        pool, 64
+    );
+    EXPECT_EQ(count, 5000);
+
+    SerialExecutor executor = SerialExecutor();
+    view.par_each([](ecs::Entity, TransformComponent*, NameComponent*) {}, executor, 1000);
+    EXPECT_EQ(executor.batches, 5);
+
+    for (auto [entity, transform] : ecs::View<TransformComponent>(&registry))
+    {
+        if (entity.id % 2 != 0)
+        {
+            EXPECT_EQ(transform->position.y, 0.0f);
+        }
+    }
+}
+
+struct Velocity
+{
+    Vector3 linear = {};
+};
+
+TEST(View, change_tracking)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.track<TransformComponent>();
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(4);
+    registry.create_entities(entities);
+    for (ecs::Entity entity : entities)
+        registry.create_component<TransformComponent>(entity);
+
+    const std::uint64_t since = registry.advance_tick();
+    registry.patch<TransformComponent>(entities[1])->position = Vector3(1, 2, 3);
+    registry.get_component<TransformComponent>(entities[2])->position = Vector3(4, 5, 6);
+
+    ecs::Entity added = registry.create_entity();
+    registry.create_component<TransformComponent>(added);
+    registry.destroy_entity(entities[3]);
+
+    std::vector<ecs::Entity> changed = {};
+    ecs::View<TransformComponent, ecs::Changed<TransformComponent>>(&registry, since)
+        .each([&changed](ecs::Entity entity, TransformComponent*) { changed.push_back(entity); });
+    std::sort(changed.begin(), changed.end());
+    EXPECT_EQ(changed, (std::vector<ecs::Entity>{entities[1], added}));
+
+    std::size_t count = 0;
+    for (auto [entity] : ecs::View<ecs::Added<TransformComponent>>(&registry, since))
+    {
+        EXPECT_TRUE(entity == added);
+        count++;
+    }
+    EXPECT_EQ(count, 1);
+
+    auto view = ecs::View<const TransformComponent, ecs::Changed<TransformComponent>>(&registry);
+    EXPECT_TRUE(view.has_required(entities[0]));
+    EXPECT_FALSE(ecs::View<ecs::Changed<TransformComponent>>(&registry, since)
+                     .has_required(entities[0]));
+
+    const ecs::ObjectPool* pool = registry.get_pool<TransformComponent>();
+    ASSERT_EQ(pool->get_removed().size(), 1);
+    EXPECT_TRUE(pool->get_removed()[0].entity == entities[3]);
+    EXPECT_GT(pool->get_removed()[0].tick, since);
+
+    registry.get_pool<TransformComponent>()->clear_removed(registry.get_tick());
+    EXPECT_TRUE(pool->get_removed().empty());
+}
+
+TEST(Scheduler, change_tracking_systems)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.track<TransformComponent>();
+    ecs::Entity entity = registry.create_entity();
+    registry.create_component<TransformComponent>(entity);
+
+    SerialExecutor executor = SerialExecutor();
+    ecs::Scheduler scheduler = ecs::Scheduler(&registry);
+
+    std::size_t seen = 0;
+    scheduler.add_view_system<const TransformComponent, ecs::Changed<TransformComponent>>(
+        [&seen](ecs::Entity, const TransformComponent*) { seen++; }
+    );
+
+    scheduler.run(executor);
+    EXPECT_EQ(seen, 1);
+    scheduler.run(executor);
+    EXPECT_EQ(seen, 1);
+
+    registry.patch<TransformComponent>(entity);
+    scheduler.run(executor);
+    EXPECT_EQ(seen, 2);
+
+    ecs::SystemAccess access =
+        ecs::SystemAccess::create_from_view<TransformComponent, ecs::Changed<Vector3>>();
+    EXPECT_EQ(access.reads.size(), 1);
+    EXPECT_EQ(access.writes.size(), 1);
+}
+
+TEST(View, exclude_and_optional)
+{
+    struct Disabled
+    {
+    };
+
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(6);
+    registry.create_entities(entities);
+    for (ecs::Entity entity : entities)
+        registry.create_component<TransformComponent>(entity);
+
+    auto view = ecs::View<TransformComponent, ecs::Exclude<Disabled>, ecs::Optional<NameComponent>>(
+        &registry
+    );
+
+    std::size_t count = 0;
+    for (auto [entity, transform, name] : view)
+    {
+        EXPECT_TRUE(transform != nullptr);
+        EXPECT_TRUE(name == nullptr);
+        count++;
+    }
+    EXPECT_EQ(count, 6);
+
+    registry.create_component<Disabled>(entities[0]);
+    registry.create_component<Disabled>(entities[1]);
+    registry.create_component<NameComponent>(entities[1], "disabled");
+    registry.create_component<NameComponent>(entities[2], "named");
+
+    std::vector<ecs::Entity> seen = {};
+    view.each(
+        [&seen, &entities](ecs::Entity entity, TransformComponent*, NameComponent* name)
+        {
+            seen.push_back(entity);
+            EXPECT_EQ(name != nullptr, entity == entities[2]);
+        }
+    );
+    std::sort(seen.begin(), seen.end());
+    EXPECT_EQ(seen, (std::vector<ecs::Entity>(entities.begin() + 2, entities.end())));
+
+    EXPECT_FALSE(view.has_required(entities[1]));
+    EXPECT_TRUE(view.has_required(entities[2]));
+    EXPECT_EQ(view.get<NameComponent>()->name, "named");
+
+    auto excluded_first = ecs::View<ecs::Exclude<Disabled>, TransformComponent>(&registry);
+    EXPECT_EQ(excluded_first.begin().get_index(), 2);
+}
+
+TEST(Group, owning_group_stays_aligned)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<TransformComponent>(ecs::ObjectPoolLayout::Packed);
+    registry.create_pool<Velocity>(ecs::ObjectPoolLayout::Packed);
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    registry.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        float value = static_cast<float>(i);
+        registry.create_component<TransformComponent>(entities[i], Vector3(value, 0, 0));
+        if (i % 2 == 0)
+            registry.create_component<Velocity>(entities[i], Velocity{Vector3(value, 0, 0)});
+        registry.create_component<NameComponent>(entities[i], std::to_string(i));
+    }
+
+    auto check = [](ecs::Registry& registry, std::size_t expected)
+    {
+        auto group = registry.group<TransformComponent, const Velocity>();
+        EXPECT_EQ(group.size(), expected);
+
+        std::span<TransformComponent> transforms = group.data<TransformComponent>();
+        std::span<const Velocity> velocities = group.data<const Velocity>();
+        for (std::size_t i = 0; i < group.size(); i++)
+        {
+            ecs::Entity entity = group.get_entities()[i];
+            EXPECT_TRUE(registry.get_component<TransformComponent>(entity) == &transforms[i]);
+            EXPECT_TRUE(registry.get_component<Velocity>(entity) == &velocities[i]);
+            EXPECT_EQ(transforms[i].position.x, velocities[i].linear.x);
+        }
+
+        std::size_t count = 0;
+        for (auto [entity, transform, velocity] : group)
+        {
+            EXPECT_EQ(transform->position.x, velocity->linear.x);
+            count++;
+        }
+        EXPECT_EQ(count, expected);
+    };
+
+    check(registry, 5);
+
+    registry.create_component<Velocity>(entities[1], Velocity{Vector3(1, 0, 0)});
+    check(registry, 6);
+
+    registry.destroy_entity(entities[0]);
+    registry.destroy_component<Velocity>(entities[4]);
+    registry.destroy_component<TransformComponent>(entities[6]);
+    check(registry, 3);
+
+    ecs::Entity created = registry.create_entity();
+    registry.create_component<Velocity>(created, Velocity{Vector3(42, 0, 0)});
+    registry.create_component<TransformComponent>(created, Vector3(42, 0, 0));
+    check(registry, 4);
+
+    registry.compact();
+    check(registry, 4);
+    EXPECT_EQ(registry.get_component<NameComponent>(entities[2])->name, "2");
+}
+
+TEST(Group, created_component_after_group_swap)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<TransformComponent>(ecs::ObjectPoolLayout::Packed);
+    registry.create_pool<Velocity>(ecs::ObjectPoolLayout::Packed);
+    registry.group<TransformComponent, Velocity>();
+
+    // Joining the group swaps the new object to the front of the packed array
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(4);
+    registry.create_entities(entities);
+    registry.create_component<Velocity>(entities[1], Velocity{Vector3(21, 0, 0)});
+    registry.create_component<TransformComponent>(entities[0]);
+    Velocity* velocity =
+        registry.create_component<Velocity>(entities[0], Velocity{Vector3(20, 0, 0)});
+    ASSERT_TRUE(velocity == registry.get_component<Velocity>(entities[0]));
+    velocity->linear.x = 30.0f;
+    EXPECT_EQ(registry.get_component<Velocity>(entities[1])->linear.x, 21.0f);
+
+    ecs::ObjectPool* pool = registry.get_pool<Velocity>();
+    registry.create_component<TransformComponent>(entities[2]);
+    std::byte* object = pool->malloc(entities[2]);
+    EXPECT_TRUE(object == pool->get_entitys_object(entities[2]));
+
+    registry.create_component<TransformComponent>(entities[3]);
+    const Velocity prototype = *registry.get_component<Velocity>(entities[1]);
+    object = pool->copy(entities[3], reinterpret_cast<const std::byte*>(&prototype));
+    EXPECT_TRUE(object == pool->get_entitys_object(entities[3]));
+    EXPECT_EQ(registry.get_component<Velocity>(entities[3])->linear.x, 21.0f);
+    EXPECT_EQ(registry.get_component<Velocity>(entities[1])->linear.x, 21.0f);
+    EXPECT_EQ(registry.get_component<Velocity>(entities[0])->linear.x, 30.0f);
+}
+
+TEST(Scheduler, build_waves)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Scheduler scheduler = ecs::Scheduler(&registry);
+
+    scheduler.add_view_system<TransformComponent, const Velocity>(
+        [](ecs::Entity, TransformComponent*, const Velocity*) {}
+    );
+    scheduler.add_view_system<const TransformComponent>([](ecs::Entity, const TransformComponent*) {
+    });
+    scheduler.add_system(ecs::Reads<NameComponent>{}, ecs::Writes<>{}, [](ecs::Registry&) {});
+    scheduler.add_system(ecs::Reads<>{}, ecs::Writes<Velocity>{}, [](ecs::Registry&) {});
+    scheduler.add_view_system<const TransformComponent, const Velocity>(
+        [](ecs::Entity, const TransformComponent*, const Velocity*) {}
+    );
+
+    std::vector<std::size_t> waves = scheduler.build_waves();
+    EXPECT_EQ(waves, std::vector<std::size_t>({0, 1, 0, 1, 2}));
+}
+
+TEST(Scheduler, run)
+{
+    ecs::Registry registry = ecs::Registry();
+    for (std::size_t i = 0; i < 1000; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity);
+        registry.create_component<Velocity>(entity)->linear = Vector3(1, 2, 3);
+    }
+
+    ecs::Scheduler scheduler = ecs::Scheduler(&registry);
+    scheduler.add_view_system<TransformComponent, const Velocity>(
+        [](ecs::Entity, TransformComponent* transform, const Velocity* velocity)
+        {
+            transform->position.x += velocity->linear.x;
+            transform->position.y += velocity->linear.y;
+            transform->position.z += velocity->linear.z;
+        }
+    );
+    scheduler.add_view_system<Velocity>([](ecs::Entity, Velocity* velocity)
+                                        { velocity->linear = Vector3(0, 0, 0); });
+
+    ecs::ThreadPool pool = ecs::ThreadPool(2);
+    scheduler.run(pool);
+    scheduler.run(pool);
+
+    for (auto [entity, transform] : ecs::View<const TransformComponent>(&registry))
+        EXPECT_TRUE(Vector3(transform->position) == Vector3(1, 2, 3));
+}
+
+struct ThreadExecutor
+{
+    void run(std::size_t count, const std::function<void(std::size_t)>& job)
+    {
+        std::vector<std::thread> threads = {};
+        for (std::size_t i = 0; i < count; i++)
+            threads.emplace_back(job, i);
+
+        for (std::thread& thread : threads)
+            thread.join();
+    }
+};
+
+TEST(Scheduler, merged_pools)
+{
+    // Pools added by hash are only cached by typed lookups outside of run()
+    ecs::Registry spawned = ecs::Registry();
+    for (std::size_t i = 0; i < 100; i++)
+    {
+        ecs::Entity entity = spawned.create_entity();
+        spawned.create_component<TransformComponent>(entity);
+        spawned.create_component<Velocity>(entity)->linear = Vector3(1, 0, 0);
+    }
+
+    ecs::Registry registry = ecs::Registry();
+    registry.merge(std::move(spawned));
+
+    std::atomic<std::size_t> count = 0;
+    ecs::Scheduler scheduler = ecs::Scheduler(&registry);
+    scheduler.add_system(
+        ecs::Reads<Velocity>(), ecs::Writes<>(),
+        [&count](ecs::Registry& registry)
+        {
+            for (auto [entity, velocity] : ecs::View<const Velocity>(&registry))
+                count += velocity->linear.x == 1.0f;
+        }
+    );
+    scheduler.add_system(
+        ecs::Reads<TransformComponent>(), ecs::Writes<>(),
+        [&count](ecs::Registry& registry)
+        {
+            for (auto [entity, transform] : ecs::View<const TransformComponent>(&registry))
+                count += registry.valid(entity);
+        }
+    );
+
+    ThreadExecutor executor = ThreadExecutor();
+    scheduler.run(executor);
+    EXPECT_EQ(count.load(), 200);
+    const std::uint64_t hash = ecs::type_descriptor::get_hash<Velocity>();
+    EXPECT_TRUE(registry.get_pool<Velocity>() == registry.get_pool(hash));
+    EXPECT_FALSE(registry.is_typed_pools_locked());
+
+    // A throwing system still unlocks the typed pools
+    scheduler.add_system(
+        ecs::Reads<>(), ecs::Writes<Velocity>(),
+        [](ecs::Registry& registry)
+        {
+            EXPECT_TRUE(registry.is_typed_pools_locked());
+            throw std::runtime_error("system failed");
+        }
+    );
+    SerialExecutor serial = SerialExecutor();
+    EXPECT_THROW(scheduler.run(serial), std::runtime_error);
+    EXPECT_FALSE(registry.is_typed_pools_locked());
+}
+
+TEST(Scheduler, profile_scopes)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_component<TransformComponent>(registry.create_entity());
+
+    int before = profile_scope_count;
+    ecs::View<TransformComponent>(&registry).each([](ecs::Entity, TransformComponent*) {});
+    EXPECT_EQ(profile_scope_count - before, 1);
+
+    SerialExecutor executor = SerialExecutor();
+    ecs::Scheduler scheduler = ecs::Scheduler(&registry);
+    scheduler.add_system(ecs::Reads<>(), ecs::Writes<>(), [](ecs::Registry&) {});
+    scheduler.add_system(ecs::Reads<>(), ecs::Writes<>(), [](ecs::Registry&) {});
+
+    before = profile_scope_count;
+    scheduler.run(executor);
+    EXPECT_EQ(profile_scope_count - before, 3);
+}
+
+TEST(Registry, destroy_component)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity entity = registry.create_entity();
+    registry.create_component<TransformComponent>(entity);
+    registry.create_component<NameComponent>(entity, "entity");
+
+    EXPECT_TRUE(registry.destroy_component<TransformComponent>(entity));
+    EXPECT_FALSE(registry.destroy_component<TransformComponent>(entity));
+    EXPECT_TRUE(registry.get_component<TransformComponent>(entity) == nullptr);
+    EXPECT_TRUE(registry.get_component<NameComponent>(entity) != nullptr);
+}
+
+TEST(CommandBuffer, flush)
+{
+    ecs::Registry registry = ecs::Registry();
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        ecs::Entity entity = registry.create_entity();
+        registry.create_component<TransformComponent>(entity, Vector3(i, i, i));
+    }
+
+    ecs::CommandBuffer buffer = ecs::CommandBuffer(64);
+    for (auto [entity, transform] : ecs::View<TransformComponent>(&registry))
+    {
+        if (entity.id % 2 == 0)
+            buffer.destroy_entity(entity);
+        else
+        {
+            buffer.create_component<NameComponent>(entity, "entity_" + std::to_string(entity.id));
+            buffer.destroy_component<TransformComponent>(entity);
+        }
+
+        ecs::Entity spawned = buffer.create_entity();
+        buffer.create_component<TransformComponent>(spawned, transform->position);
+        buffer.create_component<NameComponent>(spawned, "spawned");
+    }
+
+    EXPECT_EQ(registry.get_pool<TransformComponent>()->get_count(), 10);
+    EXPECT_TRUE(registry.get_pool<NameComponent>() == nullptr);
+
+    registry.flush(buffer);
+    EXPECT_TRUE(buffer.empty());
+
+    EXPECT_EQ(registry.get_pool<TransformComponent>()->get_count(), 10);
+    EXPECT_EQ(registry.get_pool<NameComponent>()->get_count(), 15);
+
+    for (std::size_t i = 0; i < 10; i++)
+    {
+        ecs::Entity entity = ecs::Entity{i};
+        EXPECT_TRUE(registry.get_component<TransformComponent>(entity) == nullptr);
+        if (i % 2 == 0)
+            EXPECT_TRUE(registry.get_component<NameComponent>(entity) == nullptr);
+        else
+        {
+            EXPECT_EQ(
+                registry.get_component<NameComponent>(entity)->name,
+                "entity_" + std::to_string(i)
+            );
+        }
+    }
+
+    std::size_t spawned = 0;
+    for (auto [entity, transform, name] : ecs::View<TransformComponent, NameComponent>(&registry))
+    {
+        EXPECT_EQ(name->name, "spawned");
+        spawned++;
+    }
+    EXPECT_EQ(spawned, 10);
+}
+
+TEST(CommandBuffer, clear_destroys_unflushed_components)
+{
+    static std::size_t destroyed = 0;
+    struct Counted
+    {
+        ~Counted() { destroyed++; }
+    };
+
+    {
+        ecs::CommandBuffer buffer = ecs::CommandBuffer();
+        ecs::Entity entity = buffer.create_entity();
+        buffer.create_component<Counted>(entity);
+        buffer.create_component<Counted>(entity);
+    }
+
+    EXPECT_EQ(destroyed, 2);
+}
+
+/**
+ * @brief Sample kernel over raw component columns, the loop is over contiguous floats so the
+ * compiler vectorizes it
+ */
+static void integrate_positions(std::span<Vector3> positions, std::span<const Velocity> velocities)
+{
+    float* position_data = reinterpret_cast<float*>(positions.data());
+    const float* velocity_data = reinterpret_cast<const float*>(velocities.data());
+
+    for (std::size_t i = 0; i < positions.size() * 3; i++)
+        position_data[i] += velocity_data[i];
+}
+
+TEST(View, chunks)
+{
+    ecs::Registry registry = ecs::Registry();
+    registry.create_pool<Vector3>(ecs::ObjectPoolLayout::Packed);
+    registry.create_pool<Velocity>(ecs::ObjectPoolLayout::Packed);
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(1000);
+    registry.create_entities(entities);
+    registry.create_components<Vector3>(entities, Vector3(0, 0, 0));
+    for (ecs::Entity entity : entities)
+        registry.create_component<Velocity>(entity)->linear = Vector3(1, 2, 3);
+
+    auto view = ecs::View<Vector3, const Velocity>(&registry);
+    std::size_t chunk_count = 0;
+    for (auto [chunk_entities, positions, velocities] : view.chunks())
+    {
+        EXPECT_EQ(chunk_entities.size(), 1000);
+        integrate_positions(positions, velocities);
+        chunk_count++;
+    }
+    EXPECT_EQ(chunk_count, 1);
+
+    // swap and pop moves the last velocity into the middle which splits the batches there
+    registry.destroy_component<Velocity>(entities[500]);
+
+    std::size_t entity_count = 0;
+    chunk_count = 0;
+    for (auto [chunk_entities, positions, velocities] : view.chunks())
+    {
+        for (std::size_t i = 0; i < chunk_entities.size(); i++)
+        {
+            EXPECT_TRUE(&positions[i] == registry.get_component<Vector3>(chunk_entities[i]));
+            EXPECT_TRUE(&velocities[i] == registry.get_component<Velocity>(chunk_entities[i]));
+        }
+
+        integrate_positions(positions, velocities);
+        entity_count += chunk_entities.size();
+        chunk_count++;
+    }
+
+    EXPECT_EQ(entity_count, 999);
+    EXPECT_EQ(chunk_count, 3);
+    EXPECT_TRUE(*registry.get_component<Vector3>(entities[0]) == Vector3(2, 4, 6));
+    EXPECT_TRUE(*registry.get_component<Vector3>(entities[500]) == Vector3(1, 2, 3));
+}
+
+TEST(Registry, sort)
+{
+    for (ecs::ObjectPoolLayout layout :
+         {ecs::ObjectPoolLayout::Chunked, ecs::ObjectPoolLayout::Packed})
+    {
+        ecs::Registry registry = ecs::Registry();
+        registry.create_pool<NameComponent>(layout, 4);
+
+        std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(20);
+        registry.create_entities(entities);
+        for (std::size_t i = 0; i < entities.size(); i++)
+            registry.create_component<NameComponent>(entities[i], std::to_string((i * 7) % 20));
+        registry.destroy_component<NameComponent>(entities[3]);
+        registry.create_component<NameComponent>(entities[3], "1");
+
+        auto by_value = [](const NameComponent& lhs, const NameComponent& rhs)
+        { return std::stoi(lhs.name) < std::stoi(rhs.name); };
+        registry.sort<NameComponent>(by_value);
+
+        auto check = [&registry](std::size_t expected)
+        {
+            ecs::ObjectPool* pool = registry.get_pool<NameComponent>();
+            ASSERT_EQ(pool->get_count(), expected);
+            for (std::size_t i = 0; i < pool->get_count(); i++)
+            {
+                ecs::Entity entity = pool->get_dense_entities()[i];
+                NameComponent* name = registry.get_component<NameComponent>(entity);
+                EXPECT_TRUE(reinterpret_cast<std::byte*>(name) == pool->get_object(i));
+                if (i > 0)
+                {
+                    EXPECT_LT(pool->get_object(i - 1), pool->get_object(i));
+                    NameComponent* previous =
+                        reinterpret_cast<NameComponent*>(pool->get_object(i - 1));
+                    EXPECT_LT(std::stoi(previous->name), std::stoi(name->name));
+                }
+            }
+        };
+        check(20);
+
+        // Nearly sorted, a single new entry out of place
+        ecs::Entity created = registry.create_entity();
+        registry.create_component<NameComponent>(created, "-1");
+        registry.sort<NameComponent>(by_value, ecs::SortAlgorithm::Insertion);
+        check(21);
+        EXPECT_EQ(registry.get_pool<NameComponent>()->get_dense_entities()[0], created);
+    }
+}
+
+TEST(Registry, sort_as)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    registry.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        registry.create_component<TransformComponent>(entities[i], Vector3(float(i), 0, 0));
+        if (i % 3 != 0)
+        {
+            registry.create_component<Velocity>(
+                entities[9 - i], Velocity{Vector3(float(9 - i), 0, 0)}
+            );
+        }
+    }
+
+    registry.sort<TransformComponent, Velocity>();
+
+    ecs::ObjectPool* transforms = registry.get_pool<TransformComponent>();
+    ecs::ObjectPool* velocities = registry.get_pool<Velocity>();
+    for (std::size_t i = 0; i < velocities->get_count(); i++)
+    {
+        EXPECT_EQ(transforms->get_dense_entities()[i], velocities->get_dense_entities()[i]);
+        EXPECT_EQ(
+            reinterpret_cast<TransformComponent*>(transforms->get_object(i))->position.x,
+            reinterpret_cast<Velocity*>(velocities->get_object(i))->linear.x
+        );
+    }
+
+    // The remaining entities keep their relative order after the shared ones
+    std::vector<float> rest = {};
+    for (std::size_t i = velocities->get_count(); i < transforms->get_count(); i++)
+    {
+        TransformComponent* transform =
+            reinterpret_cast<TransformComponent*>(transforms->get_object(i));
+        rest.push_back(transform->position.x);
+    }
+    EXPECT_EQ(rest, (std::vector<float>{0, 3, 6, 9}));
+}
+
+TEST(Registry, context)
+{
+    static int destroyed = 0;
+    struct Time
+    {
+        float delta = 0.0f;
+        ~Time() { destroyed++; }
+    };
+
+    {
+        ecs::Registry registry = ecs::Registry();
+        EXPECT_FALSE(registry.ctx().contains<Time>());
+        EXPECT_TRUE(registry.ctx().find<Time>() == nullptr);
+
+        Time& time = registry.ctx().emplace<Time>(0.5f);
+        EXPECT_TRUE(&registry.ctx().emplace<Time>(1.0f) == &time);
+        EXPECT_EQ(registry.ctx().get<Time>().delta, 0.5f);
+
+        registry.ctx().emplace<Vector3>(1.0f, 2.0f, 3.0f);
+        EXPECT_EQ(registry.ctx().get_count(), 2);
+        EXPECT_TRUE(registry.ctx().get<Vector3>() == Vector3(1, 2, 3));
+
+        // Resources aren't components, no pool exists for them
+        EXPECT_TRUE(registry.get_pool<Time>() == nullptr);
+
+        EXPECT_TRUE(registry.ctx().erase<Vector3>());
+        EXPECT_FALSE(registry.ctx().erase<Vector3>());
+        EXPECT_FALSE(registry.ctx().contains<Vector3>());
+        EXPECT_EQ(destroyed, 0);
+    }
+    EXPECT_EQ(destroyed, 1);
+}
+
+TEST(Registry, hierarchy)
+{
+    struct Depth
+    {
+        int local = 1;
+        int world = 0;
+    };
+
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(8);
+    registry.create_entities(entities);
+    for (ecs::Entity entity : entities)
+        registry.create_component<Depth>(entity);
+
+    // 0 -> {1 -> {3, 4}, 2}, 5 -> {6}, 7 is a root that gets reparented under 6
+    registry.set_parent(entities[3], entities[1]);
+    registry.set_parent(entities[4], entities[1]);
+    registry.set_parent(entities[2], entities[0]);
+    registry.set_parent(entities[1], entities[0]);
+    registry.set_parent(entities[6], entities[5]);
+    registry.set_parent(entities[7], entities[0]);
+    registry.set_parent(entities[7], entities[6]);
+    EXPECT_EQ(registry.get_parent(entities[7]), entities[6]);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[0])->child_count, 2);
+
+    auto accumulate = [](const Depth* parent, Depth& child)
+    { child.world = child.local + (parent != nullptr ? parent->world : 0); };
+    registry.propagate<Depth>(accumulate);
+
+    const std::vector<int> expected = {1, 2, 2, 3, 3, 1, 2, 3};
+    for (std::size_t i = 0; i < entities.size(); i++)
+        EXPECT_EQ(registry.get_component<Depth>(entities[i])->world, expected[i]);
+
+    // Depth first with the parent before its children and whole subtrees contiguous
+    ecs::ObjectPool* pool = registry.get_pool<ecs::Relationship>();
+    ecs::ObjectPool* depths = registry.get_pool<Depth>();
+    for (std::size_t i = 0; i < pool->get_count(); i++)
+    {
+        ecs::Entity entity = pool->get_dense_entities()[i];
+        EXPECT_EQ(depths->get_dense_entities()[i], entity);
+
+        auto* link = reinterpret_cast<ecs::Relationship*>(pool->get_object(i));
+        for (std::size_t j = i + 1; j <= i + link->descendant_count; j++)
+        {
+            ecs::Entity current = pool->get_dense_entities()[j];
+            while (current != ECS_ENTITY_DESTROYED && current != entity)
+                current = registry.get_parent(current);
+            EXPECT_EQ(current, entity);
+        }
+    }
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[0])->descendant_count, 4);
+
+    // Destroying a parent turns its children into roots
+    registry.destroy_entity(entities[1]);
+    EXPECT_EQ(registry.get_parent(entities[3]), ECS_ENTITY_DESTROYED);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[0])->child_count, 1);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[0])->first_child, entities[2]);
+
+    SerialExecutor executor = SerialExecutor();
+    registry.par_propagate<Depth>(accumulate, executor, 1);
+    EXPECT_EQ(executor.batches, 4);
+    EXPECT_EQ(registry.get_component<Depth>(entities[3])->world, 1);
+    EXPECT_EQ(registry.get_component<Depth>(entities[7])->world, 3);
+
+    // A second type propagated over the already sorted hierarchy is matched to it as well
+    for (std::size_t i = entities.size(); i > 2; i--)
+        registry.create_component<Velocity>(entities[i - 1]);
+    registry.create_component<Velocity>(entities[0]);
+    registry.propagate<Velocity>([](const Velocity*, Velocity&) {});
+    ecs::ObjectPool* velocities = registry.get_pool<Velocity>();
+    for (std::size_t i = 0; i < velocities->get_count(); i++)
+        EXPECT_EQ(velocities->get_dense_entities()[i], pool->get_dense_entities()[i]);
+}
+
+TEST(Registry, hierarchy_destroy_relationship)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(5);
+    registry.create_entities(entities);
+    for (std::size_t i = 1; i < entities.size(); i++)
+        registry.set_parent(entities[i], entities[0]);
+    registry.set_parent(entities[4], entities[2]);
+
+    // Children are linked 3, 2, 1 under the root, remove the middle one with its own child
+    EXPECT_TRUE(registry.destroy_component<ecs::Relationship>(entities[2]));
+    ecs::Relationship* root = registry.get_component<ecs::Relationship>(entities[0]);
+    EXPECT_EQ(root->child_count, 2);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[3])->next_sibling, entities[1]);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[1])->prev_sibling, entities[3]);
+    EXPECT_EQ(registry.get_parent(entities[4]), ECS_ENTITY_DESTROYED);
+
+    // The hashed path and command buffers unlink as well
+    EXPECT_TRUE(registry.destroy_component(
+        entities[3], ecs::type_descriptor::get_hash<ecs::Relationship>()
+    ));
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(entities[0])->first_child, entities[1]);
+
+    ecs::CommandBuffer buffer = ecs::CommandBuffer();
+    buffer.destroy_component<ecs::Relationship>(entities[1]);
+    registry.flush(buffer);
+    root = registry.get_component<ecs::Relationship>(entities[0]);
+    EXPECT_EQ(root->first_child, ECS_ENTITY_DESTROYED);
+
+    registry.set_parent(entities[3], entities[0]);
+    registry.destroy_entity(entities[0]);
+    EXPECT_EQ(registry.get_parent(entities[3]), ECS_ENTITY_DESTROYED);
+
+    std::size_t count = 0;
+    registry.propagate<ecs::Relationship>(
+        [&count](const ecs::Relationship*, ecs::Relationship&) { count++; }
+    );
+    EXPECT_EQ(count, registry.get_pool<ecs::Relationship>()->get_count());
+}
+
+TEST(Registry, hierarchy_instantiate)
+{
+    ecs::Registry registry = ecs::Registry();
+    ecs::Entity root = registry.create_entity();
+    ecs::Entity prefab = registry.create_entity();
+    registry.create_component<TransformComponent>(prefab, Vector3(1, 2, 3));
+    registry.set_parent(prefab, root);
+
+    // Copies don't share the prefab's links, so destroying one leaves the prefab linked
+    std::vector<ecs::Entity> copies = registry.instantiate(prefab, 3);
+    for (ecs::Entity copy : copies)
+    {
+        EXPECT_EQ(registry.get_parent(copy), ECS_ENTITY_DESTROYED);
+        EXPECT_TRUE(registry.get_component<TransformComponent>(copy) != nullptr);
+    }
+
+    registry.destroy_entity(copies[1]);
+    registry.set_parent(copies[2], root);
+    registry.destroy_entity(copies[2]);
+
+    const ecs::Relationship* link = registry.get_component<ecs::Relationship>(root);
+    EXPECT_EQ(link->first_child, prefab);
+    EXPECT_EQ(link->child_count, 1);
+    EXPECT_EQ(registry.get_parent(prefab), root);
+
+    std::size_t count = 0;
+    registry.propagate<ecs::Relationship>(
+        [&count](const ecs::Relationship*, ecs::Relationship&) { count++; }
+    );
+    EXPECT_EQ(count, 2);
+    EXPECT_EQ(registry.get_component<ecs::Relationship>(root)->descendant_count, 1);
+}
+
+TEST(Registry, merge)
+{
+    ecs::Registry world = ecs::Registry();
+    std::vector<ecs::Entity> existing = std::vector<ecs::Entity>(3);
+    world.create_entities(existing);
+    for (ecs::Entity entity : existing)
+        world.create_component<NameComponent>(entity, "world");
+    world.destroy_entity(existing[1]);
+
+    // Workers spawn into their own registries concurrently
+    std::vector<ecs::Registry*> workers = {new ecs::Registry(), new ecs::Registry()};
+    std::vector<std::thread> threads = {};
+    for (std::size_t w = 0; w < workers.size(); w++)
+    {
+        threads.emplace_back(
+            [registry = workers[w], w]()
+            {
+                std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(50);
+                registry->create_entities(entities);
+                for (std::size_t i = 0; i < entities.size(); i++)
+                {
+                    registry->create_component<NameComponent>(entities[i], std::to_string(i));
+                    if (i % 2 == 0)
+                        registry->create_component<TransformComponent>(entities[i]);
+                }
+
+                registry->set_parent(entities[1], entities[0]);
+                registry->destroy_entity(entities[2]);
+            }
+        );
+    }
+    for (std::thread& thread : threads)
+        thread.join();
+
+    // Spliced chunked objects stay where they are
+    ecs::Registry* worker = workers[0];
+    ecs::Entity spawned = worker->get_entities()[10];
+    NameComponent* name = worker->get_component<NameComponent>(spawned);
+
+    std::vector<ecs::Entity> remap = world.merge(std::move(*worker));
+    EXPECT_EQ(worker->get_entities().size(), 0);
+    EXPECT_EQ(worker->get_pool<NameComponent>()->get_count(), 0);
+    EXPECT_EQ(remap[2], ECS_ENTITY_DESTROYED);
+    EXPECT_TRUE(world.get_component<NameComponent>(remap[spawned.get_index()]) == name);
+    EXPECT_EQ(world.get_parent(remap[1]), remap[0]);
+
+    world.merge(std::move(*workers[1]));
+    EXPECT_EQ(world.get_pool<NameComponent>()->get_count(), 2 + 49 * 2);
+    EXPECT_EQ(world.get_pool<TransformComponent>()->get_count(), 24 * 2);
+    EXPECT_EQ(world.get_pool<ecs::Relationship>()->get_count(), 4);
+
+    std::size_t count = 0;
+    for (auto [entity, transform, merged] : ecs::View<TransformComponent, NameComponent>(&world))
+    {
+        EXPECT_TRUE(world.valid(entity));
+        EXPECT_EQ(std::stoi(merged->name) % 2, 0);
+        count++;
+    }
+    EXPECT_EQ(count, 48);
+    EXPECT_EQ(world.get_component<NameComponent>(existing[2])->name, "world");
+
+    // The chunks merged in are reused after the objects in them are destroyed
+    world.destroy_entity(remap[spawned.get_index()]);
+    ecs::Entity created = world.create_entity();
+    world.create_component<NameComponent>(created, "reused");
+    EXPECT_EQ(world.get_component<NameComponent>(created)->name, "reused");
+
+    for (ecs::Registry* registry : workers)
+        delete registry;
+}
+
+TEST(Registry, merge_packed)
+{
+    ecs::Registry world = ecs::Registry();
+    world.create_pool<NameComponent>(ecs::ObjectPoolLayout::Packed);
+    world.create_component<NameComponent>(world.create_entity(), "world");
+
+    ecs::Registry worker = ecs::Registry();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    worker.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+        worker.create_component<NameComponent>(entities[i], std::to_string(i));
+
+    std::vector<ecs::Entity> remap = world.merge(std::move(worker));
+    ecs::ObjectPool* pool = world.get_pool<NameComponent>();
+    EXPECT_EQ(pool->get_layout(), ecs::ObjectPoolLayout::Packed);
+    ASSERT_EQ(pool->get_count(), 11);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        NameComponent* name = world.get_component<NameComponent>(remap[i]);
+        ASSERT_TRUE(name != nullptr);
+        EXPECT_EQ(name->name, std::to_string(i));
+    }
+}
+
+TEST(ConcurrentRegistry, threads)
+{
+    ecs::Registry registry = ecs::Registry();
+    std::vector<ecs::Entity> shared = std::vector<ecs::Entity>(16);
+    registry.create_entities(shared);
+    for (ecs::Entity entity : shared)
+        registry.create_component<Velocity>(entity);
+
+    {
+        ecs::ConcurrentRegistry concurrent = ecs::ConcurrentRegistry(registry, 256);
+        std::vector<std::thread> threads = {};
+        for (std::size_t t = 0; t < 4; t++)
+        {
+            threads.emplace_back(
+                [&concurrent, &shared]()
+                {
+                    for (std::size_t i = 0; i < 200; i++)
+                    {
+                        ecs::Entity entity = concurrent.create_entity();
+                        EXPECT_TRUE(concurrent.valid(entity));
+                        concurrent.create_component<TransformComponent>(entity);
+                        concurrent.create_component<NameComponent>(entity, std::to_string(i));
+                        if (i % 4 == 0)
+                            concurrent.destroy_entity(entity);
+
+                        for (ecs::Entity target : shared)
+                        {
+                            concurrent.write<Velocity>(
+                                target, [](Velocity& velocity) { velocity.linear.x += 1.0f; }
+                            );
+                        }
+                        concurrent.read<Velocity>(
+                            shared[i % shared.size()],
+                            [](const Velocity& velocity) { EXPECT_GE(velocity.linear.x, 1.0f); }
+                        );
+                    }
+                }
+            );
+        }
+        for (std::thread& thread : threads)
+            thread.join();
+
+        EXPECT_FALSE(concurrent.read<Vector3>(shared[0], [](const Vector3&) {}));
+        EXPECT_TRUE(concurrent.destroy_component<Velocity>(shared[0]));
+        EXPECT_FALSE(concurrent.write<Velocity>(shared[0], [](Velocity&) {}));
+    }
+
+    EXPECT_EQ(registry.get_pool<TransformComponent>()->get_count(), 600);
+    EXPECT_EQ(registry.get_pool<NameComponent>()->get_count(), 600);
+    EXPECT_EQ(registry.get_component<Velocity>(shared[1])->linear.x, 800.0f);
+
+    // Entities reserved up front but never handed out are destroyed with the wrapper
+    EXPECT_EQ(registry.get_stats().entity_count, 16 + 600);
+}
+
+TEST(StaticRegistry, typed_pools)
+{
+    using World = ecs::StaticRegistry<TransformComponent, Velocity>;
+    static_assert(World::index_of<Velocity>() == 1);
+    static_assert(World::contains<const TransformComponent>());
+    static_assert(!World::contains<NameComponent>());
+
+    World registry = World();
+    EXPECT_EQ(registry.get_pools().size(), 2);
+    EXPECT_TRUE(registry.get_pool<Velocity>() == registry.ecs::Registry::get_pool<Velocity>());
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    registry.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        float value = static_cast<float>(i);
+        registry.create_component<TransformComponent>(entities[i], Vector3(value, 0, 0));
+        if (i % 2 == 0)
+            registry.create_component<Velocity>(entities[i], Velocity{Vector3(1, 0, 0)});
+        if (i % 5 == 0)
+            registry.create_component<NameComponent>(entities[i], std::to_string(i));
+    }
+
+    std::size_t count = 0;
+    registry.view<TransformComponent, const Velocity>().each(
+        [&count](ecs::Entity, TransformComponent* transform, const Velocity* velocity)
+        {
+            transform->position.x += velocity->linear.x;
+            count++;
+        }
+    );
+    EXPECT_EQ(count, 5);
+    EXPECT_EQ(registry.get_component<TransformComponent>(entities[4])->position.x, 5.0f);
+    EXPECT_EQ(registry.get_component<TransformComponent>(entities[5])->position.x, 5.0f);
+
+    // Types outside the set and the runtime path go through the regular registry
+    count = 0;
+    for (auto [entity, name] : registry.view<NameComponent, ecs::Exclude<Velocity>>())
+    {
+        EXPECT_TRUE(entity == entities[5]);
+        EXPECT_EQ(name->name, "5");
+        count++;
+    }
+    EXPECT_EQ(count, 1);
+
+    ecs::Entity scripted = registry.create_entity();
+    std::byte* object = registry.create_component(
+        scripted, 42, "Scripted", sizeof(int), nullptr, [](std::byte* type) { new (type) int(7); }
+    );
+    EXPECT_EQ(*reinterpret_cast<int*>(object), 7);
+    EXPECT_TRUE(registry.get_component(scripted, 42) == object);
+
+    EXPECT_TRUE(registry.destroy_component<Velocity>(entities[0]));
+    EXPECT_TRUE(registry.get_component<Velocity>(entities[0]) == nullptr);
+}
+
+TEST(Replication, delta_encoding)
+{
+    struct Position
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+    struct Health
+    {
+        int value = 100;
+    };
+
+    ecs::Registry server = ecs::Registry();
+    server.track<Position>();
+    server.track<Health>();
+    server.create_component<NameComponent>(server.create_entity(), "not replicated");
+
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(100);
+    server.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+    {
+        server.create_component<Position>(entities[i], float(i), 0.0f);
+        server.create_component<Health>(entities[i]);
+    }
+
+    ecs::Registry client = ecs::Registry();
+    ecs::ReplicationBaseline server_baseline = ecs::ReplicationBaseline();
+    ecs::ReplicationBaseline client_baseline = ecs::ReplicationBaseline();
+    ecs::DeltaEncoder encoder = ecs::DeltaEncoder();
+    SerialExecutor executor = SerialExecutor();
+
+    auto check = [&server, &client]()
+    {
+        for (auto* pool : {server.get_pool<Position>(), server.get_pool<Health>()})
+        {
+            ecs::ObjectPool* mirror = client.get_pool(pool->get_type_hash());
+            ASSERT_TRUE(mirror != nullptr);
+            ASSERT_EQ(mirror->get_count(), pool->get_count());
+            for (std::size_t i = 0; i < pool->get_count(); i++)
+            {
+                std::byte* object = mirror->get_entitys_object(pool->get_dense_entities()[i]);
+                ASSERT_TRUE(object != nullptr);
+                EXPECT_EQ(std::memcmp(object, pool->get_object(i), pool->get_type_size()), 0);
+            }
+        }
+    };
+
+    std::vector<std::byte> full = {};
+    encoder.encode(server, server_baseline, full, executor);
+    EXPECT_EQ(executor.batches, 2);
+    ASSERT_TRUE(client.apply_delta(full, &client_baseline));
+    check();
+    EXPECT_TRUE(server_baseline.apply(full));
+    EXPECT_TRUE(client_baseline.apply(full));
+
+    // Encoding ends the tick so writes right after it are sent by the next delta
+    const ecs::DeltaHeader* header = reinterpret_cast<const ecs::DeltaHeader*>(full.data());
+    EXPECT_LT(header->tick, server.get_tick());
+
+    // Only what changed since the acknowledged baseline is sent
+    server.patch<Position>(entities[3])->x = 42.0f;
+    server.patch<Health>(entities[5]);
+    server.destroy_component<Health>(entities[7]);
+    std::vector<std::byte> first = {};
+    encoder.encode(server, server_baseline, first, executor);
+    EXPECT_LT(first.size(), full.size() / 10);
+    ASSERT_TRUE(client.apply_delta(first, &client_baseline));
+    check();
+
+    // Unacknowledged deltas keep every change since the baseline, so one can be lost
+    server.patch<Position>(entities[9])->y = 1.0f;
+    server.destroy_entity(entities[10]);
+    ecs::Entity created = server.create_entity();
+    server.create_component<Health>(created, 50);
+    std::vector<std::byte> lost = {};
+    encoder.encode(server, server_baseline, lost, executor);
+
+    server.get_component<Position>(entities[3])->x = 43.0f;
+    server.patch<Position>(entities[3]);
+    std::vector<std::byte> second = {};
+    encoder.encode(server, server_baseline, second, executor);
+    ASSERT_TRUE(client.apply_delta(second, &client_baseline));
+    check();
+    EXPECT_EQ(client.get_pool<Health>()->get_count(), 99);
+
+    // Both sides acknowledge the same delta and agree on the next one
+    EXPECT_TRUE(server_baseline.apply(second));
+    EXPECT_TRUE(client_baseline.apply(second));
+    std::vector<std::byte> empty = {};
+    encoder.encode(server, server_baseline, empty, executor);
+    EXPECT_EQ(empty.size(), sizeof(ecs::DeltaHeader));
+    EXPECT_FALSE(client.apply_delta(std::span<const std::byte>(empty.data(), 4)));
+}
+
+TEST(Replication, malformed_delta)
+{
+    struct Position
+    {
+        float x = 0.0f;
+        float y = 0.0f;
+    };
+
+    ecs::Registry server = ecs::Registry();
+    server.track<Position>();
+    std::vector<ecs::Entity> entities = std::vector<ecs::Entity>(10);
+    server.create_entities(entities);
+    for (std::size_t i = 0; i < entities.size(); i++)
+        server.create_component<Position>(entities[i], float(i), 0.0f);
+
+    std::vector<std::byte> delta = {};
+    ecs::DeltaEncoder encoder = ecs::DeltaEncoder();
+    SerialExecutor executor = SerialExecutor();
+    encoder.encode(server, ecs::ReplicationBaseline(), delta, executor);
+
+    for (std::size_t size = 0; size < delta.size(); size++)
+    {
+        ecs::Registry client = ecs::Registry();
+        EXPECT_FALSE(client.apply_delta(std::span<const std::byte>(delta.data(), size)));
+    }
+
+    auto apply_modified = [&delta](auto modify)
+    {
+        std::vector<std::byte> modified = delta;
+        ecs::DeltaPoolHeader pool_header = {};
+        std::memcpy(&pool_header, modified.data() + sizeof(ecs::DeltaHeader), sizeof(pool_header));
+        modify(pool_header);
+        std::memcpy(modified.data() + sizeof(ecs::DeltaHeader), &pool_header, sizeof(pool_header));
+
+        ecs::Registry client = ecs::Registry();
+        return client.apply_delta(modified);
+    };
+
+    EXPECT_TRUE(apply_modified([](ecs::DeltaPoolHeader&) {}));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header) { header.count = 1ull << 61; }));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header)
+                                { header.removed_count = 1ull << 61; }));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header)
+                                { header.type_size = 1ull << 62; }));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header) { header.alignment = 0; }));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header) { header.alignment = 12; }));
+    EXPECT_FALSE(apply_modified([](ecs::DeltaPoolHeader& header) { header.name_size = 0; }));
+
+    // An existing pool with the hash of the delta but another type size is never written to
+    ecs::Registry client = ecs::Registry();
+    client.create_component<int>(client.create_entity());
+    std::vector<std::byte> renamed = delta;
+    ecs::DeltaPoolHeader pool_header = {};
+    std::memcpy(&pool_header, renamed.data() + sizeof(ecs::DeltaHeader), sizeof(pool_header));
+    pool_header.hash = ecs::type_descriptor::get_hash<int>();
+    std::memcpy(renamed.data() + sizeof(ecs::DeltaHeader), &pool_header, sizeof(pool_header));
+    EXPECT_FALSE(client.apply_delta(renamed));
+    EXPECT_EQ(client.get_pool<int>()->get_count(), 1);
+}
+
 int main(int argc, char** argv)
 {
     testing::InitGoogleTest(&argc, argv);